@@ -0,0 +1,206 @@
+/*
+ * main.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of the AutomappingRunner, which applies the automapping
+ * rules of Tiled to a map from the command line.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "automapper.h"
+#include "automappingmanager.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "tmxmapreader.h"
+#include "tmxmapwriter.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace {
+
+struct CommandLineOptions {
+    CommandLineOptions()
+        : showHelp(false)
+        , profile(false)
+    {}
+
+    bool showHelp;
+    bool profile;
+    QString rulesFile;
+    QString mapFile;
+    QString outputFile;
+};
+
+} // anonymous namespace
+
+static void showHelp()
+{
+    qWarning() <<
+            "Usage: automappingrunner [options] map [output]\n\n"
+            "Applies the automapping rules to the map, and writes the result\n"
+            "to output when given.\n\n"
+            "Options:\n"
+            "  -h --help          : Display this help\n"
+            "  -r --rules <file>  : Use the given rules file instead of the\n"
+            "                       rules.txt next to the map\n"
+            "  -p --profile       : Print the matches, compared positions,\n"
+            "                       output and time spent for each rule";
+}
+
+static void parseCommandLineArguments(CommandLineOptions &options)
+{
+    const QStringList arguments = QCoreApplication::arguments();
+
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString &arg = arguments.at(i);
+        if (arg == QLatin1String("--help") || arg == QLatin1String("-h")) {
+            options.showHelp = true;
+        } else if (arg == QLatin1String("--profile")
+                || arg == QLatin1String("-p")) {
+            options.profile = true;
+        } else if (arg == QLatin1String("--rules")
+                || arg == QLatin1String("-r")) {
+            if (i + 1 < arguments.size()) {
+                options.rulesFile = arguments.at(++i);
+            } else {
+                qWarning() << "Missing rules file after" << arg;
+                options.showHelp = true;
+            }
+        } else if (arg.startsWith(QLatin1Char('-'))) {
+            qWarning() << "Unknown option" << arg;
+            options.showHelp = true;
+        } else if (options.mapFile.isEmpty()) {
+            options.mapFile = arg;
+        } else if (options.outputFile.isEmpty()) {
+            options.outputFile = arg;
+        } else {
+            qWarning() << "Unexpected argument" << arg;
+            options.showHelp = true;
+        }
+    }
+}
+
+static void printProfile(QTextStream &out,
+                         const QVector<AutoMapper*> &autoMappers)
+{
+    foreach (const AutoMapper *autoMapper, autoMappers) {
+        out << QFileInfo(autoMapper->rulePath()).fileName() << '\n';
+        out << QString(QLatin1String("%1 %2 %3 %4 %5 %6 %7 %8\n"))
+               .arg(QLatin1String("rule"), 5)
+               .arg(QLatin1String("position"), 10)
+               .arg(QLatin1String("matches"), 10)
+               .arg(QLatin1String("compared"), 12)
+               .arg(QLatin1String("applied"), 10)
+               .arg(QLatin1String("cells"), 10)
+               .arg(QLatin1String("objects"), 8)
+               .arg(QLatin1String("time (ms)"), 10);
+
+        const QVector<RuleProfile> &profiles = autoMapper->ruleProfiles();
+        qint64 total = 0;
+
+        for (int i = 0; i < profiles.size(); ++i) {
+            const RuleProfile &profile = profiles.at(i);
+            const QString position = QString(QLatin1String("%1,%2"))
+                    .arg(profile.bounds.x())
+                    .arg(profile.bounds.y());
+
+            out << QString(QLatin1String("%1 %2 %3 %4 %5 %6 %7 %8\n"))
+                   .arg(i + 1, 5)
+                   .arg(position, 10)
+                   .arg(profile.matches, 10)
+                   .arg(profile.candidates, 12)
+                   .arg(profile.applied, 10)
+                   .arg(profile.cellsWritten, 10)
+                   .arg(profile.objectsWritten, 8)
+                   .arg(profile.elapsed / 1000.0, 10, 'f', 3);
+
+            total += profile.elapsed;
+        }
+
+        out << QString(QLatin1String("total %1 ms\n\n"))
+               .arg(total / 1000.0, 0, 'f', 3);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // The tiles are loaded as pixmaps, so a full application is needed
+    QApplication a(argc, argv);
+
+    a.setOrganizationDomain(QLatin1String("mapeditor.org"));
+    a.setApplicationName(QLatin1String("AutomappingRunner"));
+    a.setApplicationVersion(QLatin1String("1.0"));
+
+    CommandLineOptions options;
+    parseCommandLineArguments(options);
+
+    if (options.showHelp || options.mapFile.isEmpty()) {
+        showHelp();
+        return options.showHelp ? 0 : 1;
+    }
+
+    TmxMapReader mapReader;
+    Map *map = mapReader.read(options.mapFile);
+    if (!map) {
+        qWarning() << "Error opening map:"
+                   << qPrintable(mapReader.errorString());
+        return 1;
+    }
+
+    MapDocument *mapDocument = new MapDocument(map, options.mapFile);
+
+    AutomappingManager *manager = AutomappingManager::instance();
+    manager->setRulesFileName(options.rulesFile);
+    manager->setProfiling(options.profile);
+    manager->setMapDocument(mapDocument);
+    manager->autoMap();
+
+    int result = 0;
+
+    if (!manager->warningString().isEmpty())
+        qWarning() << qPrintable(manager->warningString());
+
+    if (!manager->errorString().isEmpty()) {
+        qWarning() << qPrintable(manager->errorString());
+        result = 1;
+    }
+
+    if (result == 0 && options.profile) {
+        QTextStream out(stdout);
+        printProfile(out, manager->autoMappers());
+    }
+
+    if (result == 0 && !options.outputFile.isEmpty()) {
+        TmxMapWriter mapWriter;
+        if (!mapWriter.write(mapDocument->map(), options.outputFile)) {
+            qWarning() << "Error writing map:"
+                       << qPrintable(mapWriter.errorString());
+            result = 1;
+        }
+    }
+
+    manager->setMapDocument(0);
+    AutomappingManager::deleteInstance();
+    delete mapDocument;
+
+    return result;
+}
@@ -75,18 +75,26 @@ QRectF IsometricRenderer::boundingRect(const MapObject *object) const
                       bottomCenter.y() - img.height(),
                       img.width(),
                       img.height()).adjusted(-1, -1 - nameHeight, 1, 1);
-    } else if (!object->polygon().isEmpty()) {
-        const QPointF &pos = object->position();
-        const QPolygonF polygon = object->polygon().translated(pos);
-        const QPolygonF screenPolygon = tileToPixelCoords(polygon);
-        return screenPolygon.boundingRect().adjusted(-2, -2 - nameHeight, 3, 3);
-    } else {
-        // Take the bounding rect of the projected object, and then add a few
-        // pixels on all sides to correct for the line width.
-        const QRectF base = tileRectToPolygon(object->bounds()).boundingRect();
+    }
+
+    ObjectGeometry &geometry = objectGeometry(object);
+    if (!geometry.hasBoundingRect) {
+        if (!object->polygon().isEmpty()) {
+            const QPolygonF &screenPolygon = geometry.screenPolygon;
+            geometry.boundingRect = screenPolygon.boundingRect()
+                    .adjusted(-2, -2 - nameHeight, 3, 3);
+        } else {
+            // Take the bounding rect of the projected object, and then add a
+            // few pixels on all sides to correct for the line width.
+            const QRectF base =
+                    tileRectToPolygon(object->bounds()).boundingRect();
 
-        return base.adjusted(-2, -3 - nameHeight, 2, 2);
+            geometry.boundingRect = base.adjusted(-2, -3 - nameHeight, 2, 2);
+        }
+        geometry.hasBoundingRect = true;
     }
+
+    return geometry.boundingRect;
 }
 
 QPainterPath IsometricRenderer::shape(const MapObject *object) const
@@ -95,6 +103,10 @@ QPainterPath IsometricRenderer::shape(const MapObject *object) const
     if (object->tile()) {
         path.addRect(boundingRect(object));
     } else {
+        ObjectGeometry &geometry = objectGeometry(object);
+        if (geometry.hasShape)
+            return geometry.shape;
+
         switch (object->shape()) {
         case MapObject::Ellipse:
         case MapObject::Rectangle:
@@ -102,21 +114,17 @@ QPainterPath IsometricRenderer::shape(const MapObject *object) const
             break;
         case MapObject::Polygon:
         case MapObject::Polyline: {
-            const QPointF &pos = object->position();
-            const QPolygonF polygon = object->polygon().translated(pos);
-            const QPolygonF screenPolygon = tileToPixelCoords(polygon);
-            if (object->shape() == MapObject::Polygon) {
+            const QPolygonF &screenPolygon = geometry.screenPolygon;
+            if (object->shape() == MapObject::Polygon)
                 path.addPolygon(screenPolygon);
-            } else {
-                for (int i = 1; i < screenPolygon.size(); ++i) {
-                    path.addPolygon(lineToPolygon(screenPolygon[i - 1],
-                                                  screenPolygon[i]));
-                }
-                path.setFillRule(Qt::WindingFill);
-            }
+            else
+                path = polylineShape(screenPolygon);
             break;
         }
         }
+
+        geometry.shape = path;
+        geometry.hasShape = true;
     }
     return path;
 }
@@ -158,7 +166,8 @@ void IsometricRenderer::drawGrid(QPainter *painter, const QRectF &rect,
 
 void IsometricRenderer::drawTileLayer(QPainter *painter,
                                       const TileLayer *layer,
-                                      const QRectF &exposed) const
+                                      const QRectF &exposed,
+                                      const QList<const TileLayer*> &occluders) const
 {
     const int tileWidth = map()->tileWidth();
     const int tileHeight = map()->tileHeight();
@@ -212,7 +221,7 @@ void IsometricRenderer::drawTileLayer(QPainter *painter,
     // Determine whether the current row is shifted half a tile to the right
     bool shifted = inUpperHalf ^ inLeftHalf;
 
-    QTransform baseTransform = painter->transform();
+    const bool cullOccluded = !occluders.isEmpty();
 
     for (int y = startPos.y(); y - tileHeight < rect.bottom();
          y += tileHeight / 2)
@@ -222,44 +231,18 @@ void IsometricRenderer::drawTileLayer(QPainter *painter,
         for (int x = startPos.x(); x < rect.right(); x += tileWidth) {
             if (layer->contains(columnItr)) {
                 const Cell &cell = layer->cellAt(columnItr);
-                if (!cell.isEmpty()) {
-                    const QPixmap &img = cell.tile->image();
+                if (!cell.isEmpty() && !(cullOccluded &&
+                        isOccluded(layer, columnItr.x(), columnItr.y(),
+                                   occluders))) {
+                    const QPixmap &img = cell.tile->image(cell.flippedHorizontally,
+                                                          cell.flippedVertically,
+                                                          cell.flippedAntiDiagonally);
                     const QPoint offset = cell.tile->tileset()->tileOffset();
 
-                    qreal m11 = 1;      // Horizontal scaling factor
-                    qreal m12 = 0;      // Vertical shearing factor
-                    qreal m21 = 0;      // Horizontal shearing factor
-                    qreal m22 = 1;      // Vertical scaling factor
-                    qreal dx = offset.x() + x;
-                    qreal dy = offset.y() + y - img.height();
-
-                    if (cell.flippedAntiDiagonally) {
-                        // Use shearing to swap the X/Y axis
-                        m11 = 0;
-                        m12 = 1;
-                        m21 = 1;
-                        m22 = 0;
-
-                        // Compensate for the swap of image dimensions
-                        dy += img.height() - img.width();
-                    }
-                    if (cell.flippedHorizontally) {
-                        m11 = -m11;
-                        m21 = -m21;
-                        dx += cell.flippedAntiDiagonally ? img.height()
-                                                         : img.width();
-                    }
-                    if (cell.flippedVertically) {
-                        m12 = -m12;
-                        m22 = -m22;
-                        dy += cell.flippedAntiDiagonally ? img.width()
-                                                         : img.height();
-                    }
-
-                    const QTransform transform(m11, m12, m21, m22, dx, dy);
-                    painter->setTransform(transform * baseTransform);
-
-                    painter->drawPixmap(0, 0, img);
+                    // Flipped images are cached, so no transformation is needed
+                    painter->drawPixmap(offset.x() + x,
+                                        offset.y() + y - img.height(),
+                                        img);
                 }
             }
 
@@ -279,8 +262,6 @@ void IsometricRenderer::drawTileLayer(QPainter *painter,
             shifted = false;
         }
     }
-
-    painter->setTransform(baseTransform);
 }
 
 void IsometricRenderer::drawTileSelection(QPainter *painter,
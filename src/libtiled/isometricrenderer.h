@@ -55,7 +55,9 @@ public:
     void drawGrid(QPainter *painter, const QRectF &rect, QColor grid) const;
 
     void drawTileLayer(QPainter *painter, const TileLayer *layer,
-                       const QRectF &exposed = QRectF()) const;
+                       const QRectF &exposed = QRectF(),
+                       const QList<const TileLayer*> &occluders =
+                            QList<const TileLayer*>()) const;
 
     void drawTileSelection(QPainter *painter,
                            const QRegion &region,
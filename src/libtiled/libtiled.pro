@@ -31,13 +31,17 @@ SOURCES += compression.cpp \
     layer.cpp \
     map.cpp \
     mapobject.cpp \
+    mapobjectindex.cpp \
     mapreader.cpp \
     maprenderer.cpp \
     mapwriter.cpp \
     objectgroup.cpp \
+    occupancybitmap.cpp \
     orthogonalrenderer.cpp \
     properties.cpp \
+    sparsecells.cpp \
     staggeredrenderer.cpp \
+    tile.cpp \
     tilelayer.cpp \
     tileset.cpp \
     gidmapper.cpp
@@ -47,13 +51,16 @@ HEADERS += compression.h \
     layer.h \
     map.h \
     mapobject.h \
+    mapobjectindex.h \
     mapreader.h \
     maprenderer.h \
     mapwriter.h \
     object.h \
     objectgroup.h \
+    occupancybitmap.h \
     orthogonalrenderer.h \
     properties.h \
+    sparsecells.h \
     staggeredrenderer.h \
     tile.h \
     tiled_global.h \
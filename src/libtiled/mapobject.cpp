@@ -29,14 +29,26 @@
 
 #include "mapobject.h"
 
+#include "objectgroup.h"
+
+#include <QAtomicInt>
+
 using namespace Tiled;
 
+static QAtomicInt revisionCounter(0);
+
+static uint nextRevision()
+{
+    return uint(revisionCounter.fetchAndAddRelaxed(1)) + 1;
+}
+
 MapObject::MapObject():
     mSize(0, 0),
     mShape(Rectangle),
     mTile(0),
     mObjectGroup(0),
-    mVisible(true)
+    mVisible(true),
+    mRevision(nextRevision())
 {
 }
 
@@ -50,8 +62,69 @@ MapObject::MapObject(const QString &name, const QString &type,
     mShape(Rectangle),
     mTile(0),
     mObjectGroup(0),
-    mVisible(true)
+    mVisible(true),
+    mRevision(nextRevision())
+{
+}
+
+void MapObject::setName(const QString &name)
+{
+    mName = name;
+    mRevision = nextRevision();
+}
+
+void MapObject::setPosition(const QPointF &pos)
+{
+    mPos = pos;
+    geometryChanged();
+}
+
+void MapObject::setX(qreal x)
+{
+    mPos.setX(x);
+    geometryChanged();
+}
+
+void MapObject::setY(qreal y)
+{
+    mPos.setY(y);
+    geometryChanged();
+}
+
+void MapObject::setSize(const QSizeF &size)
 {
+    mSize = size;
+    geometryChanged();
+}
+
+void MapObject::setWidth(qreal width)
+{
+    mSize.setWidth(width);
+    geometryChanged();
+}
+
+void MapObject::setHeight(qreal height)
+{
+    mSize.setHeight(height);
+    geometryChanged();
+}
+
+void MapObject::setPolygon(const QPolygonF &polygon)
+{
+    mPolygon = polygon;
+    geometryChanged();
+}
+
+void MapObject::setShape(Shape shape)
+{
+    mShape = shape;
+    geometryChanged();
+}
+
+void MapObject::setTile(Tile *tile)
+{
+    mTile = tile;
+    geometryChanged();
 }
 
 MapObject *MapObject::clone() const
@@ -63,3 +136,15 @@ MapObject *MapObject::clone() const
     o->setTile(mTile);
     return o;
 }
+
+/**
+ * Updates the revision of this object and lets the object group know that
+ * its geometry changed, so that it can keep its spatial index up to date.
+ */
+void MapObject::geometryChanged()
+{
+    mRevision = nextRevision();
+
+    if (mObjectGroup)
+        mObjectGroup->objectGeometryChanged(this);
+}
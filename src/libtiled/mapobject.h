@@ -93,7 +93,7 @@ public:
     /**
      * Sets the name of this object.
      */
-    void setName(const QString &name) { mName = name; }
+    void setName(const QString &name);
 
     /**
      * Returns the type of this object. The type usually says something about
@@ -114,7 +114,7 @@ public:
     /**
      * Sets the position of this object.
      */
-    void setPosition(const QPointF &pos) { mPos = pos; }
+    void setPosition(const QPointF &pos);
 
     /**
      * Returns the x position of this object.
@@ -124,7 +124,7 @@ public:
     /**
      * Sets the x position of this object.
      */
-    void setX(qreal x) { mPos.setX(x); }
+    void setX(qreal x);
 
     /**
      * Returns the y position of this object.
@@ -134,7 +134,7 @@ public:
     /**
      * Sets the x position of this object.
      */
-    void setY(qreal y) { mPos.setY(y); }
+    void setY(qreal y);
 
     /**
      * Returns the size of this object.
@@ -144,7 +144,7 @@ public:
     /**
      * Sets the size of this object.
      */
-    void setSize(const QSizeF &size) { mSize = size; }
+    void setSize(const QSizeF &size);
 
     void setSize(qreal width, qreal height)
     { setSize(QSizeF(width, height)); }
@@ -157,7 +157,7 @@ public:
     /**
      * Sets the width of this object.
      */
-    void setWidth(qreal width) { mSize.setWidth(width); }
+    void setWidth(qreal width);
 
     /**
      * Returns the height of this object.
@@ -167,7 +167,7 @@ public:
     /**
      * Sets the height of this object.
      */
-    void setHeight(qreal height) { mSize.setHeight(height); }
+    void setHeight(qreal height);
 
     /**
      * Sets the polygon associated with this object. The polygon is only used
@@ -175,7 +175,7 @@ public:
      *
      * \sa setShape()
      */
-    void setPolygon(const QPolygonF &polygon) { mPolygon = polygon; }
+    void setPolygon(const QPolygonF &polygon);
 
     /**
      * Returns the polygon associated with this object. Returns an empty
@@ -186,7 +186,7 @@ public:
     /**
      * Sets the shape of the object.
      */
-    void setShape(Shape shape) { mShape = shape; }
+    void setShape(Shape shape);
 
     /**
      * Returns the shape of the object.
@@ -204,7 +204,7 @@ public:
      *
      * \warning The object shape is ignored for tile objects!
      */
-    void setTile(Tile *tile) { mTile = tile; }
+    void setTile(Tile *tile);
 
     /**
      * Returns the tile associated with this object.
@@ -232,7 +232,16 @@ public:
     bool isVisible() const { return mVisible; }
     void setVisible(bool visible) { mVisible = visible; }
 
+    /**
+     * Returns the revision of this object. The revision changes whenever the
+     * name or the geometry of the object changes, and is unique among all
+     * objects. This allows caching information derived from the object.
+     */
+    uint revision() const { return mRevision; }
+
 private:
+    void geometryChanged();
+
     QString mName;
     QString mType;
     QPointF mPos;
@@ -242,6 +251,7 @@ private:
     Tile *mTile;
     ObjectGroup *mObjectGroup;
     bool mVisible;
+    uint mRevision;
 };
 
 } // namespace Tiled
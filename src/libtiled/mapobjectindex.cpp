@@ -0,0 +1,178 @@
+/*
+ * mapobjectindex.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mapobjectindex.h"
+
+#include <QSet>
+
+#include <cmath>
+
+using namespace Tiled;
+
+/**
+ * Objects spanning more than this amount of buckets are not put in the grid.
+ */
+static const int maxBucketsPerObject = 64;
+
+MapObjectIndex::MapObjectIndex(int bucketSize)
+    : mBucketSize(qMax(1, bucketSize))
+{
+}
+
+void MapObjectIndex::insert(MapObject *object, const QRectF &bounds)
+{
+    if (mEntries.contains(object))
+        remove(object);
+
+    Entry entry;
+    entry.bounds = bounds.normalized();
+    entry.buckets = bucketRange(entry.bounds);
+    entry.large = entry.buckets.width() * entry.buckets.height()
+            > maxBucketsPerObject;
+    entry.hasTileRegion = false;
+
+    if (entry.large) {
+        mLargeObjects.append(object);
+    } else {
+        for (int y = entry.buckets.top(); y <= entry.buckets.bottom(); ++y)
+            for (int x = entry.buckets.left(); x <= entry.buckets.right(); ++x)
+                mBuckets[bucketKey(x, y)].append(object);
+    }
+
+    mEntries.insert(object, entry);
+}
+
+void MapObjectIndex::remove(MapObject *object)
+{
+    QHash<MapObject*, Entry>::iterator it = mEntries.find(object);
+    if (it == mEntries.end())
+        return;
+
+    const Entry &entry = it.value();
+
+    if (entry.large) {
+        mLargeObjects.removeOne(object);
+    } else {
+        for (int y = entry.buckets.top(); y <= entry.buckets.bottom(); ++y) {
+            for (int x = entry.buckets.left(); x <= entry.buckets.right(); ++x) {
+                const quint64 key = bucketKey(x, y);
+                QVector<MapObject*> &bucket = mBuckets[key];
+                const int index = bucket.indexOf(object);
+                if (index != -1)
+                    bucket.remove(index);
+                if (bucket.isEmpty())
+                    mBuckets.remove(key);
+            }
+        }
+    }
+
+    mEntries.erase(it);
+}
+
+void MapObjectIndex::clear()
+{
+    mEntries.clear();
+    mBuckets.clear();
+    mLargeObjects.clear();
+}
+
+bool MapObjectIndex::tileRegion(MapObject *object, QRegion *region) const
+{
+    QHash<MapObject*, Entry>::const_iterator it = mEntries.find(object);
+    if (it == mEntries.end() || !it.value().hasTileRegion)
+        return false;
+
+    *region = it.value().tileRegion;
+    return true;
+}
+
+void MapObjectIndex::setTileRegion(MapObject *object, const QRegion &region)
+{
+    QHash<MapObject*, Entry>::iterator it = mEntries.find(object);
+    if (it == mEntries.end())
+        return;
+
+    it.value().hasTileRegion = true;
+    it.value().tileRegion = region;
+}
+
+QList<MapObject*> MapObjectIndex::query(const QRectF &rect) const
+{
+    QList<MapObject*> result;
+    const QRectF area = rect.normalized();
+    const QRect range = bucketRange(area);
+
+    // When the area covers more buckets than there are objects, it is
+    // cheaper to simply check every object.
+    if (qint64(range.width()) * range.height() > mEntries.size()) {
+        QHash<MapObject*, Entry>::const_iterator it = mEntries.constBegin();
+        QHash<MapObject*, Entry>::const_iterator it_end = mEntries.constEnd();
+        for (; it != it_end; ++it)
+            if (intersects(it.value().bounds, area))
+                result.append(it.key());
+        return result;
+    }
+
+    QSet<MapObject*> found;
+
+    for (int y = range.top(); y <= range.bottom(); ++y) {
+        for (int x = range.left(); x <= range.right(); ++x) {
+            QHash<quint64, QVector<MapObject*> >::const_iterator bucket =
+                    mBuckets.find(bucketKey(x, y));
+            if (bucket == mBuckets.constEnd())
+                continue;
+
+            foreach (MapObject *object, bucket.value()) {
+                if (found.contains(object))
+                    continue;
+                if (intersects(mEntries.value(object).bounds, area)) {
+                    found.insert(object);
+                    result.append(object);
+                }
+            }
+        }
+    }
+
+    foreach (MapObject *object, mLargeObjects)
+        if (intersects(mEntries.value(object).bounds, area))
+            result.append(object);
+
+    return result;
+}
+
+/**
+ * Returns the range of buckets (inclusive) touched by the given \a rect.
+ */
+QRect MapObjectIndex::bucketRange(const QRectF &rect) const
+{
+    const int left = (int) std::floor(rect.left() / mBucketSize);
+    const int top = (int) std::floor(rect.top() / mBucketSize);
+    const int right = (int) std::floor(rect.right() / mBucketSize);
+    const int bottom = (int) std::floor(rect.bottom() / mBucketSize);
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
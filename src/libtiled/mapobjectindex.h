@@ -0,0 +1,151 @@
+/*
+ * mapobjectindex.h
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_MAPOBJECTINDEX_H
+#define TILED_MAPOBJECTINDEX_H
+
+#include "tiled_global.h"
+
+#include <QHash>
+#include <QList>
+#include <QRect>
+#include <QRectF>
+#include <QRegion>
+#include <QVector>
+
+namespace Tiled {
+
+class MapObject;
+
+/**
+ * A spatial index over map objects, implemented as a uniform grid of buckets
+ * in tile coordinates. It is used to quickly find the objects that are
+ * within a certain area, without looking at every object.
+ *
+ * Each object is indexed by a rectangle given in tile coordinates. Objects
+ * that span a lot of buckets are kept in a separate list, which is checked
+ * on every query.
+ */
+class TILEDSHARED_EXPORT MapObjectIndex
+{
+public:
+    /**
+     * Constructor. The \a bucketSize is the size of each grid bucket in
+     * tiles.
+     */
+    explicit MapObjectIndex(int bucketSize = 8);
+
+    /**
+     * Inserts the given \a object with the given \a bounds, or updates its
+     * bounds when it is already part of the index.
+     */
+    void insert(MapObject *object, const QRectF &bounds);
+
+    /**
+     * Removes the given \a object from the index.
+     */
+    void remove(MapObject *object);
+
+    /**
+     * Removes all objects from the index.
+     */
+    void clear();
+
+    /**
+     * Returns whether the given \a object is part of this index.
+     */
+    bool contains(MapObject *object) const
+    { return mEntries.contains(object); }
+
+    /**
+     * Returns the bounds with which the given \a object was indexed.
+     */
+    QRectF bounds(MapObject *object) const
+    { return mEntries.value(object).bounds; }
+
+    /**
+     * Looks up the tile region stored for the given \a object through
+     * setTileRegion(). Returns false when there is none, which is the case
+     * again after the object is inserted anew because its geometry changed.
+     */
+    bool tileRegion(MapObject *object, QRegion *region) const;
+
+    /**
+     * Stores the tile region covered by the given \a object, so that it does
+     * not need to be computed again until the object changes.
+     */
+    void setTileRegion(MapObject *object, const QRegion &region);
+
+    /**
+     * Returns the number of indexed objects.
+     */
+    int count() const { return mEntries.size(); }
+
+    /**
+     * Returns the objects whose bounds intersect the given \a rect. Edges
+     * are inclusive, so that objects without size are found as well. The
+     * returned objects are in no particular order.
+     */
+    QList<MapObject*> query(const QRectF &rect) const;
+
+    /**
+     * Returns the objects whose bounds contain the given \a point.
+     */
+    QList<MapObject*> query(const QPointF &point) const
+    { return query(QRectF(point, QSizeF(0, 0))); }
+
+private:
+    struct Entry
+    {
+        QRectF bounds;
+        QRect buckets;
+        bool large;
+        bool hasTileRegion;
+        QRegion tileRegion;
+    };
+
+    QRect bucketRange(const QRectF &rect) const;
+
+    static quint64 bucketKey(int x, int y)
+    { return (quint64(quint32(x)) << 32) | quint32(y); }
+
+    static bool intersects(const QRectF &a, const QRectF &b)
+    {
+        return a.left() <= b.right() && a.right() >= b.left() &&
+                a.top() <= b.bottom() && a.bottom() >= b.top();
+    }
+
+    int mBucketSize;
+    QHash<MapObject*, Entry> mEntries;
+    QHash<quint64, QVector<MapObject*> > mBuckets;
+    QList<MapObject*> mLargeObjects;
+};
+
+} // namespace Tiled
+
+#endif // TILED_MAPOBJECTINDEX_H
@@ -20,10 +20,81 @@
 
 #include "maprenderer.h"
 
+#include "map.h"
+#include "mapobject.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QPainterPathStroker>
 #include <QVector2D>
 
 using namespace Tiled;
 
+/**
+ * The cache of object geometry is cleared when it grows beyond this size, to
+ * get rid of the entries of objects that no longer exist.
+ */
+static const int maxCachedObjectGeometry = 1 << 18;
+
+QRectF MapRenderer::pixelToTileBoundingRect(const QRectF &rect) const
+{
+    QPolygonF polygon(4);
+    polygon[0] = pixelToTileCoords(rect.topLeft());
+    polygon[1] = pixelToTileCoords(rect.topRight());
+    polygon[2] = pixelToTileCoords(rect.bottomRight());
+    polygon[3] = pixelToTileCoords(rect.bottomLeft());
+
+    // Some renderers snap to tiles when converting, so add one tile of slack
+    return polygon.boundingRect().adjusted(-1, -1, 1, 1);
+}
+
+/**
+ * Returns whether the given \a cell is drawn exactly within the bounds of its
+ * cell on a map with the given tile size.
+ */
+static bool fillsCell(const Cell &cell, int tileWidth, int tileHeight)
+{
+    const Tile *tile = cell.tile;
+    if (!tile || !tile->tileset()->tileOffset().isNull())
+        return false;
+
+    int width = tile->width();
+    int height = tile->height();
+    if (cell.flippedAntiDiagonally)
+        std::swap(width, height);
+
+    return width == tileWidth && height == tileHeight;
+}
+
+bool MapRenderer::isOccluded(const TileLayer *layer, int x, int y,
+                             const QList<const TileLayer*> &occluders) const
+{
+    const int tileWidth = mMap->tileWidth();
+    const int tileHeight = mMap->tileHeight();
+
+    // Tiles sticking out of their cell may still be partially visible
+    if (!fillsCell(layer->cellAt(x, y), tileWidth, tileHeight))
+        return false;
+
+    const int mapX = x + layer->x();
+    const int mapY = y + layer->y();
+
+    foreach (const TileLayer *occluder, occluders) {
+        const int occluderX = mapX - occluder->x();
+        const int occluderY = mapY - occluder->y();
+        if (!occluder->contains(occluderX, occluderY))
+            continue;
+
+        const Cell &cell = occluder->cellAt(occluderX, occluderY);
+        if (cell.tile && cell.tile->isOpaque() &&
+                fillsCell(cell, tileWidth, tileHeight))
+            return true;
+    }
+
+    return false;
+}
+
 /**
  * Converts a line running from \a start to \a end to a polygon which
  * extends 5 pixels from the line in all directions.
@@ -44,3 +115,48 @@ QPolygonF MapRenderer::lineToPolygon(const QPointF &start, const QPointF &end)
     polygon[3] = end + perpendicular + direction;
     return polygon;
 }
+
+MapRenderer::ObjectGeometry &MapRenderer::objectGeometry(
+        const MapObject *object) const
+{
+    QHash<const MapObject*, ObjectGeometry>::iterator it =
+            mObjectGeometry.find(object);
+
+    if (it == mObjectGeometry.end()) {
+        if (mObjectGeometry.size() >= maxCachedObjectGeometry)
+            mObjectGeometry.clear();
+        it = mObjectGeometry.insert(object, ObjectGeometry());
+    }
+
+    ObjectGeometry &geometry = it.value();
+
+    // Revisions are unique, so this also catches a different object that
+    // happens to be allocated at the address of a deleted one.
+    if (geometry.revision != object->revision()) {
+        geometry = ObjectGeometry();
+        geometry.revision = object->revision();
+
+        const QPolygonF &polygon = object->polygon();
+        if (!polygon.isEmpty())
+            geometry.screenPolygon =
+                    tileToPixelCoords(polygon.translated(object->position()));
+    }
+
+    return geometry;
+}
+
+QPainterPath MapRenderer::polylineShape(const QPolygonF &screenPolygon)
+{
+    QPainterPath line;
+    line.addPolygon(screenPolygon);
+
+    // Matches the polygons produced by lineToPolygon() for each segment
+    QPainterPathStroker stroker;
+    stroker.setWidth(10);
+    stroker.setCapStyle(Qt::SquareCap);
+    stroker.setJoinStyle(Qt::MiterJoin);
+
+    QPainterPath path = stroker.createStroke(line);
+    path.setFillRule(Qt::WindingFill);
+    return path;
+}
@@ -31,7 +31,10 @@
 
 #include "tiled_global.h"
 
+#include <QHash>
+#include <QList>
 #include <QPainter>
+#include <QPainterPath>
 
 namespace Tiled {
 
@@ -91,9 +94,15 @@ public:
      *
      * Optionally, you can pass in the \a exposed rect (of pixels), so that
      * only tiles that can be visible in this area will be drawn.
+     *
+     * The \a occluders are the tile layers that will be drawn on top of this
+     * layer at full opacity. Cells that are completely hidden behind opaque
+     * tiles on these layers are not drawn.
      */
     virtual void drawTileLayer(QPainter *painter, const TileLayer *layer,
-                               const QRectF &exposed = QRectF()) const = 0;
+                               const QRectF &exposed = QRectF(),
+                               const QList<const TileLayer*> &occluders =
+                                    QList<const TileLayer*>()) const = 0;
 
     /**
      * Draws the tile selection given by \a region in the specified \a color.
@@ -113,6 +122,13 @@ public:
                                const MapObject *object,
                                const QColor &color) const = 0;
 
+    /**
+     * Returns the distance in pixels by which drawMapObject() may draw
+     * outside of the bounds of an object, to account for its name, the pen
+     * width and the markers used for objects without size.
+     */
+    static qreal objectMargin() { return 20; }
+
     /**
      * Draws the given image \a layer using the given \a painter.
      */
@@ -144,6 +160,13 @@ public:
         return screenPolygon;
     }
 
+    /**
+     * Returns the bounding rectangle in tile coordinates of the given pixel
+     * \a rect. This can be used to look up the objects that may be drawn
+     * within an exposed area.
+     */
+    QRectF pixelToTileBoundingRect(const QRectF &rect) const;
+
     static QPolygonF lineToPolygon(const QPointF &start, const QPointF &end);
 
 protected:
@@ -152,8 +175,53 @@ protected:
      */
     const Map *map() const { return mMap; }
 
+    /**
+     * Returns whether the cell at \a x, \a y (in local coordinates) of the
+     * given \a layer is completely hidden by opaque tiles on any of the
+     * \a occluders.
+     */
+    bool isOccluded(const TileLayer *layer, int x, int y,
+                    const QList<const TileLayer*> &occluders) const;
+
+    /**
+     * The geometry of a map object in pixels, as derived by a renderer. It is
+     * cached since it is requested often during mouse interaction and
+     * repainting, while it only changes when the object is changed.
+     */
+    struct ObjectGeometry
+    {
+        ObjectGeometry()
+            : revision(0)
+            , hasBoundingRect(false)
+            , hasShape(false)
+        {}
+
+        uint revision;
+        QPolygonF screenPolygon;    // Object polygon in pixel coordinates
+        QRectF boundingRect;
+        QPainterPath shape;
+        bool hasBoundingRect;
+        bool hasShape;
+    };
+
+    /**
+     * Returns the cached geometry of the given \a object. The cached entry is
+     * reset when the object revision has changed since it was cached.
+     *
+     * The returned reference stays valid until the next call.
+     */
+    ObjectGeometry &objectGeometry(const MapObject *object) const;
+
+    /**
+     * Returns a path covering the given polyline with a margin of 5 pixels
+     * on each side, used as the shape of polyline objects.
+     */
+    static QPainterPath polylineShape(const QPolygonF &screenPolygon);
+
 private:
     const Map *mMap;
+
+    mutable QHash<const MapObject*, ObjectGeometry> mObjectGeometry;
 };
 
 } // namespace Tiled
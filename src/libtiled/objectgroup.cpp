@@ -36,16 +36,21 @@
 #include "tile.h"
 #include "tileset.h"
 
+#include <QPair>
+#include <QVector>
+
 using namespace Tiled;
 
 ObjectGroup::ObjectGroup()
     : Layer(ObjectGroupType, QString(), 0, 0, 0, 0)
+    , mObjectOrderDirty(false)
 {
 }
 
 ObjectGroup::ObjectGroup(const QString &name,
                          int x, int y, int width, int height)
     : Layer(ObjectGroupType, name, x, y, width, height)
+    , mObjectOrderDirty(false)
 {
 }
 
@@ -58,12 +63,21 @@ void ObjectGroup::addObject(MapObject *object)
 {
     mObjects.append(object);
     object->setObjectGroup(this);
+    indexObject(object);
+
+    if (!mObjectOrderDirty) {
+        const int order = mObjects.size() == 1
+                ? 0 : mObjectOrder.value(mObjects.at(mObjects.size() - 2)) + 1;
+        mObjectOrder.insert(object, order);
+    }
 }
 
 void ObjectGroup::insertObject(int index, MapObject *object)
 {
     mObjects.insert(index, object);
     object->setObjectGroup(this);
+    indexObject(object);
+    mObjectOrderDirty = true;
 }
 
 int ObjectGroup::removeObject(MapObject *object)
@@ -71,8 +85,7 @@ int ObjectGroup::removeObject(MapObject *object)
     const int index = mObjects.indexOf(object);
     Q_ASSERT(index != -1);
 
-    mObjects.removeAt(index);
-    object->setObjectGroup(0);
+    removeObjectAt(index);
     return index;
 }
 
@@ -80,6 +93,77 @@ void ObjectGroup::removeObjectAt(int index)
 {
     MapObject *object = mObjects.takeAt(index);
     object->setObjectGroup(0);
+    mIndex.remove(object);
+
+    // Removing an object leaves the relative order of the others intact
+    mObjectOrder.remove(object);
+}
+
+QList<MapObject*> ObjectGroup::objectsIntersecting(const QRectF &rect) const
+{
+    QRectF area = rect.normalized();
+
+    // Tile objects are indexed by their position, while their image extends
+    // up and to the right from there.
+    if (!mMaxTileObjectSize.isEmpty() && mMap) {
+        area.adjust(-qreal(mMaxTileObjectSize.width()) / mMap->tileWidth(), 0,
+                    0, qreal(mMaxTileObjectSize.height()) / mMap->tileHeight());
+    }
+
+    const QList<MapObject*> found = mIndex.query(area);
+    if (found.size() < 2)
+        return found;
+
+    if (mObjectOrderDirty) {
+        mObjectOrder.clear();
+        for (int i = 0, i_end = mObjects.size(); i < i_end; ++i)
+            mObjectOrder.insert(mObjects.at(i), i);
+        mObjectOrderDirty = false;
+    }
+
+    QVector<QPair<int, MapObject*> > sorted;
+    sorted.reserve(found.size());
+    foreach (MapObject *object, found)
+        sorted.append(qMakePair(mObjectOrder.value(object), object));
+    qSort(sorted);
+
+    QList<MapObject*> result;
+#if QT_VERSION >= 0x040700
+    result.reserve(sorted.size());
+#endif
+    for (int i = 0, i_end = sorted.size(); i < i_end; ++i)
+        result.append(sorted.at(i).second);
+    return result;
+}
+
+void ObjectGroup::objectGeometryChanged(MapObject *object)
+{
+    Q_ASSERT(object->objectGroup() == this);
+    indexObject(object);
+}
+
+/**
+ * Inserts the \a object into the spatial index, or updates its entry. The
+ * object is indexed by its bounds in tile coordinates. Tile objects are only
+ * indexed by their position, since the size of their image is in pixels.
+ */
+void ObjectGroup::indexObject(MapObject *object)
+{
+    QRectF bounds;
+
+    if (const Tile *tile = object->tile()) {
+        bounds = QRectF(object->position(), QSizeF(0, 0));
+        mMaxTileObjectSize = mMaxTileObjectSize.expandedTo(tile->size());
+    } else if (!object->polygon().isEmpty() &&
+               (object->shape() == MapObject::Polygon ||
+                object->shape() == MapObject::Polyline)) {
+        bounds = object->polygon().boundingRect();
+        bounds.translate(object->position());
+    } else {
+        bounds = object->bounds();
+    }
+
+    mIndex.insert(object, bounds);
 }
 
 QRectF ObjectGroup::objectsBoundingRect() const
@@ -34,8 +34,10 @@
 #include "tiled_global.h"
 
 #include "layer.h"
+#include "mapobjectindex.h"
 
 #include <QColor>
+#include <QHash>
 #include <QList>
 #include <QMetaType>
 
@@ -104,6 +106,49 @@ public:
      */
     void removeObjectAt(int index);
 
+    /**
+     * Returns the objects that may intersect the given \a rect, which is
+     * given in tile coordinates. The objects are returned in the same order
+     * as they appear in objects().
+     *
+     * This is a fast lookup based on an approximation of the object bounds
+     * in tile coordinates, so it may return objects that don't actually
+     * intersect the rect. Callers needing exact results should test the
+     * returned objects against their actual shape.
+     */
+    QList<MapObject*> objectsIntersecting(const QRectF &rect) const;
+
+    /**
+     * Returns the objects that may cover the given \a pos, which is given in
+     * tile coordinates.
+     *
+     * \sa objectsIntersecting()
+     */
+    QList<MapObject*> objectsAt(const QPointF &pos) const
+    { return objectsIntersecting(QRectF(pos, QSizeF(0, 0))); }
+
+    /**
+     * Updates the spatial index for the given \a object. Should only be called
+     * from the MapObject class, when its geometry has changed.
+     */
+    void objectGeometryChanged(MapObject *object);
+
+    /**
+     * Looks up the tile region cached for the given \a object. Returns false
+     * when none was cached since the geometry of the object last changed.
+     *
+     * \sa MapObjectIndex::tileRegion()
+     */
+    bool cachedTileRegion(MapObject *object, QRegion *region) const
+    { return mIndex.tileRegion(object, region); }
+
+    /**
+     * Caches the tile region covered by the given \a object, until its
+     * geometry changes.
+     */
+    void setCachedTileRegion(MapObject *object, const QRegion &region)
+    { mIndex.setTileRegion(object, region); }
+
     /**
      * Returns the bounding rect around all objects in this object group.
      */
@@ -169,8 +214,17 @@ protected:
     ObjectGroup *initializeClone(ObjectGroup *clone) const;
 
 private:
+    void indexObject(MapObject *object);
+
     QList<MapObject*> mObjects;
     QColor mColor;
+
+    MapObjectIndex mIndex;
+    QSize mMaxTileObjectSize;
+
+    // Keeps track of the order of the objects, for sorting query results
+    mutable QHash<const MapObject*, int> mObjectOrder;
+    mutable bool mObjectOrderDirty;
 };
 
 } // namespace Tiled
@@ -0,0 +1,312 @@
+/*
+ * occupancybitmap.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "occupancybitmap.h"
+
+#include <QtAlgorithms>
+
+#include <climits>
+
+using namespace Tiled;
+
+bool OccupancyBitmap::contains(int x, int y) const
+{
+    QHash<quint64, Chunk>::const_iterator it =
+            mChunks.find(chunkKey(x >> ChunkShift, y >> ChunkShift));
+    if (it == mChunks.constEnd())
+        return false;
+
+    const quint64 bit = quint64(1) << (x & ChunkMask);
+    return (it.value().rows[y & ChunkMask] & bit) != 0;
+}
+
+bool OccupancyBitmap::intersects(const QRect &rect) const
+{
+    if (rect.isEmpty() || mChunks.isEmpty())
+        return false;
+
+    const int firstChunkX = rect.left() >> ChunkShift;
+    const int lastChunkX = rect.right() >> ChunkShift;
+    const int firstChunkY = rect.top() >> ChunkShift;
+    const int lastChunkY = rect.bottom() >> ChunkShift;
+
+    for (int chunkY = firstChunkY; chunkY <= lastChunkY; ++chunkY) {
+        const int top = qMax(rect.top(), chunkY * ChunkSize) & ChunkMask;
+        const int bottom = qMin(rect.bottom(),
+                                (chunkY * ChunkSize) + ChunkMask) & ChunkMask;
+
+        for (int chunkX = firstChunkX; chunkX <= lastChunkX; ++chunkX) {
+            QHash<quint64, Chunk>::const_iterator it =
+                    mChunks.find(chunkKey(chunkX, chunkY));
+            if (it == mChunks.constEnd())
+                continue;
+
+            const int left = qMax(rect.left(), chunkX * ChunkSize)
+                    & ChunkMask;
+            const int right = qMin(rect.right(),
+                                   (chunkX * ChunkSize) + ChunkMask)
+                    & ChunkMask;
+            const quint64 mask = rowMask(left, right);
+            const quint64 *rows = it.value().rows;
+
+            for (int y = top; y <= bottom; ++y)
+                if (rows[y] & mask)
+                    return true;
+        }
+    }
+
+    return false;
+}
+
+bool OccupancyBitmap::intersects(const QRegion &region) const
+{
+    foreach (const QRect &rect, region.rects())
+        if (intersects(rect))
+            return true;
+    return false;
+}
+
+void OccupancyBitmap::add(const QRect &rect)
+{
+    if (rect.isEmpty())
+        return;
+
+    const int firstChunkX = rect.left() >> ChunkShift;
+    const int lastChunkX = rect.right() >> ChunkShift;
+    const int firstChunkY = rect.top() >> ChunkShift;
+    const int lastChunkY = rect.bottom() >> ChunkShift;
+
+    for (int chunkY = firstChunkY; chunkY <= lastChunkY; ++chunkY) {
+        const int top = qMax(rect.top(), chunkY * ChunkSize) & ChunkMask;
+        const int bottom = qMin(rect.bottom(),
+                                (chunkY * ChunkSize) + ChunkMask) & ChunkMask;
+
+        for (int chunkX = firstChunkX; chunkX <= lastChunkX; ++chunkX) {
+            const int left = qMax(rect.left(), chunkX * ChunkSize)
+                    & ChunkMask;
+            const int right = qMin(rect.right(),
+                                   (chunkX * ChunkSize) + ChunkMask)
+                    & ChunkMask;
+            const quint64 mask = rowMask(left, right);
+            quint64 *rows = mChunks[chunkKey(chunkX, chunkY)].rows;
+
+            for (int y = top; y <= bottom; ++y)
+                rows[y] |= mask;
+        }
+    }
+}
+
+void OccupancyBitmap::add(const QRegion &region)
+{
+    foreach (const QRect &rect, region.rects())
+        add(rect);
+}
+
+void OccupancyBitmap::add(const OccupancyBitmap &other)
+{
+    QHash<quint64, Chunk>::const_iterator it = other.mChunks.constBegin();
+    QHash<quint64, Chunk>::const_iterator it_end = other.mChunks.constEnd();
+    for (; it != it_end; ++it) {
+        quint64 *rows = mChunks[it.key()].rows;
+        const quint64 *otherRows = it.value().rows;
+        for (int y = 0; y < ChunkSize; ++y)
+            rows[y] |= otherRows[y];
+    }
+}
+
+QRect OccupancyBitmap::boundingRect() const
+{
+    int left = INT_MAX;
+    int top = INT_MAX;
+    int right = INT_MIN;
+    int bottom = INT_MIN;
+
+    QHash<quint64, Chunk>::const_iterator it = mChunks.constBegin();
+    QHash<quint64, Chunk>::const_iterator it_end = mChunks.constEnd();
+    for (; it != it_end; ++it) {
+        const int chunkX = int(quint32(it.key() >> 32)) * ChunkSize;
+        const int chunkY = int(quint32(it.key())) * ChunkSize;
+        const quint64 *rows = it.value().rows;
+
+        quint64 columns = 0;
+        for (int y = 0; y < ChunkSize; ++y) {
+            if (!rows[y])
+                continue;
+
+            columns |= rows[y];
+            top = qMin(top, chunkY + y);
+            bottom = qMax(bottom, chunkY + y);
+        }
+
+        if (!columns)
+            continue;
+
+        int first = 0;
+        while (!(columns & (quint64(1) << first)))
+            ++first;
+        int last = ChunkMask;
+        while (!(columns & (quint64(1) << last)))
+            --last;
+
+        left = qMin(left, chunkX + first);
+        right = qMax(right, chunkX + last);
+    }
+
+    if (left > right)
+        return QRect();
+
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+QRegion OccupancyBitmap::toRegion() const
+{
+    QVector<QRect> runs;
+    appendRuns(boundingRect(), runs);
+
+    QRegion region;
+    if (!runs.isEmpty())
+        region.setRects(runs.constData(), runs.size());
+    return region;
+}
+
+static bool runLessThan(const QRect &a, const QRect &b)
+{
+    if (a.top() != b.top())
+        return a.top() < b.top();
+    return a.left() < b.left();
+}
+
+QRegion OccupancyBitmap::toRegion(const QRegion &clip) const
+{
+    const QVector<QRect> clipRects = clip.rects();
+    QVector<QRect> runs;
+
+    foreach (const QRect &rect, clipRects)
+        appendRuns(rect, runs);
+
+    QRegion region;
+    if (runs.isEmpty())
+        return region;
+
+    // The runs of each clip rect are in order, but those of different clip
+    // rects need to be merged. Runs of neighbouring clip rects may also touch,
+    // in which case they are joined.
+    if (clipRects.size() > 1) {
+        qSort(runs.begin(), runs.end(), runLessThan);
+
+        int last = 0;
+        for (int i = 1; i < runs.size(); ++i) {
+            const QRect run = runs.at(i);
+            QRect &previous = runs[last];
+            if (run.top() == previous.top()
+                    && run.left() == previous.right() + 1) {
+                previous.setRight(run.right());
+            } else {
+                runs[++last] = run;
+            }
+        }
+        runs.resize(last + 1);
+    }
+
+    region.setRects(runs.constData(), runs.size());
+    return region;
+}
+
+/**
+ * Appends the runs of consecutive positions within \a rect to \a runs, as
+ * rects of one tile high, ordered by row and then by column. This is the
+ * order expected by QRegion::setRects().
+ */
+void OccupancyBitmap::appendRuns(const QRect &rect,
+                                 QVector<QRect> &runs) const
+{
+    if (rect.isEmpty() || mChunks.isEmpty())
+        return;
+
+    const int firstChunkX = rect.left() >> ChunkShift;
+    const int lastChunkX = rect.right() >> ChunkShift;
+    QVector<const Chunk*> chunks(lastChunkX - firstChunkX + 1);
+    int currentChunkY = 0;
+
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        // Look up the chunks covering this row when entering a new chunk row
+        const int chunkY = y >> ChunkShift;
+        if (y == rect.top() || chunkY != currentChunkY) {
+            currentChunkY = chunkY;
+            for (int chunkX = firstChunkX; chunkX <= lastChunkX; ++chunkX) {
+                QHash<quint64, Chunk>::const_iterator it =
+                        mChunks.find(chunkKey(chunkX, chunkY));
+                chunks[chunkX - firstChunkX] =
+                        (it == mChunks.constEnd()) ? 0 : &it.value();
+            }
+        }
+
+        int runStart = rect.left();
+        bool inRun = false;
+
+        for (int chunkX = firstChunkX; chunkX <= lastChunkX; ++chunkX) {
+            const int chunkLeft = chunkX * ChunkSize;
+            const int left = qMax(rect.left(), chunkLeft);
+            const int right = qMin(rect.right(), chunkLeft + ChunkMask);
+
+            const Chunk *chunk = chunks.at(chunkX - firstChunkX);
+            const quint64 mask = rowMask(left & ChunkMask, right & ChunkMask);
+            const quint64 bits = chunk ? chunk->rows[y & ChunkMask] & mask : 0;
+
+            if (bits == mask) {
+                if (!inRun) {
+                    runStart = left;
+                    inRun = true;
+                }
+                continue;
+            }
+
+            if (!bits) {
+                if (inRun) {
+                    runs.append(QRect(runStart, y, left - runStart, 1));
+                    inRun = false;
+                }
+                continue;
+            }
+
+            for (int x = left; x <= right; ++x) {
+                const bool set = (bits & (quint64(1) << (x & ChunkMask))) != 0;
+                if (set && !inRun) {
+                    runStart = x;
+                    inRun = true;
+                } else if (!set && inRun) {
+                    runs.append(QRect(runStart, y, x - runStart, 1));
+                    inRun = false;
+                }
+            }
+        }
+
+        if (inRun)
+            runs.append(QRect(runStart, y, rect.right() + 1 - runStart, 1));
+    }
+}
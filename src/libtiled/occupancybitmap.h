@@ -0,0 +1,151 @@
+/*
+ * occupancybitmap.h
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OCCUPANCYBITMAP_H
+#define OCCUPANCYBITMAP_H
+
+#include "tiled_global.h"
+
+#include <QHash>
+#include <QPoint>
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace Tiled {
+
+/**
+ * A set of tile positions, stored as one bit per tile in chunks of 64x64
+ * tiles. Only the chunks in which tiles were added take up memory, so the
+ * positions may be spread out over any area, including negative ones.
+ *
+ * Adding rects and testing them for intersection takes time proportional to
+ * their area, independent of how many positions were added before. This
+ * makes it a faster alternative to QRegion for building up a complex region
+ * while checking what is already part of it.
+ */
+class TILEDSHARED_EXPORT OccupancyBitmap
+{
+public:
+    /**
+     * Returns whether no position has been added.
+     */
+    bool isEmpty() const { return mChunks.isEmpty(); }
+
+    /**
+     * Removes all positions.
+     */
+    void clear() { mChunks.clear(); }
+
+    /**
+     * Returns whether the given position is part of this bitmap.
+     */
+    bool contains(int x, int y) const;
+    bool contains(const QPoint &point) const
+    { return contains(point.x(), point.y()); }
+
+    /**
+     * Returns whether any position within \a rect is part of this bitmap.
+     */
+    bool intersects(const QRect &rect) const;
+
+    /**
+     * Returns whether any position within \a region is part of this bitmap.
+     */
+    bool intersects(const QRegion &region) const;
+
+    /**
+     * Adds the given position.
+     */
+    void add(int x, int y) { add(QRect(x, y, 1, 1)); }
+
+    /**
+     * Adds all positions within the given \a rect.
+     */
+    void add(const QRect &rect);
+
+    /**
+     * Adds all positions within the given \a region.
+     */
+    void add(const QRegion &region);
+
+    /**
+     * Adds all positions that are part of \a other.
+     */
+    void add(const OccupancyBitmap &other);
+
+    /**
+     * Returns the bounding rect of all positions, or an empty rect when this
+     * bitmap is empty.
+     */
+    QRect boundingRect() const;
+
+    /**
+     * Returns the positions as a region.
+     */
+    QRegion toRegion() const;
+
+    /**
+     * Returns the positions that are within the given \a clip region.
+     */
+    QRegion toRegion(const QRegion &clip) const;
+
+private:
+    enum {
+        ChunkShift = 6,
+        ChunkSize = 1 << ChunkShift,
+        ChunkMask = ChunkSize - 1
+    };
+
+    /**
+     * A square of tiles, with one 64-bit word for each row.
+     */
+    struct Chunk
+    {
+        Chunk() { qMemSet(rows, 0, sizeof(rows)); }
+
+        quint64 rows[ChunkSize];
+    };
+
+    static quint64 chunkKey(int chunkX, int chunkY)
+    { return (quint64(quint32(chunkX)) << 32) | quint32(chunkY); }
+
+    /**
+     * Returns the bits from \a first to \a last within a row of a chunk.
+     */
+    static quint64 rowMask(int first, int last)
+    { return (~quint64(0) >> (ChunkMask - (last - first))) << first; }
+
+    void appendRuns(const QRect &rect, QVector<QRect> &runs) const;
+
+    QHash<quint64, Chunk> mChunks;
+};
+
+} // namespace Tiled
+
+#endif // OCCUPANCYBITMAP_H
@@ -72,6 +72,10 @@ QRectF OrthogonalRenderer::boundingRect(const MapObject *object) const
                               img.width(),
                               img.height()).adjusted(-1, -1, 1, 1);
     } else {
+        ObjectGeometry &geometry = objectGeometry(object);
+        if (geometry.hasBoundingRect)
+            return geometry.boundingRect;
+
         // The -2 and +3 are to account for the pen width and shadow
         switch (object->shape()) {
         case MapObject::Ellipse:
@@ -86,13 +90,14 @@ QRectF OrthogonalRenderer::boundingRect(const MapObject *object) const
 
         case MapObject::Polygon:
         case MapObject::Polyline: {
-            const QPointF &pos = object->position();
-            const QPolygonF polygon = object->polygon().translated(pos);
-            QPolygonF screenPolygon = tileToPixelCoords(polygon);
+            const QPolygonF &screenPolygon = geometry.screenPolygon;
             boundingRect = screenPolygon.boundingRect().adjusted(-2, -2, 3, 3);
             break;
         }
         }
+
+        geometry.boundingRect = boundingRect;
+        geometry.hasBoundingRect = true;
     }
 
     return boundingRect;
@@ -105,6 +110,10 @@ QPainterPath OrthogonalRenderer::shape(const MapObject *object) const
     if (object->tile()) {
         path.addRect(boundingRect(object));
     } else {
+        ObjectGeometry &geometry = objectGeometry(object);
+        if (geometry.hasShape)
+            return geometry.shape;
+
         switch (object->shape()) {
         case MapObject::Rectangle: {
             const QRectF bounds = object->bounds();
@@ -120,18 +129,11 @@ QPainterPath OrthogonalRenderer::shape(const MapObject *object) const
         }
         case MapObject::Polygon:
         case MapObject::Polyline: {
-            const QPointF &pos = object->position();
-            const QPolygonF polygon = object->polygon().translated(pos);
-            const QPolygonF screenPolygon = tileToPixelCoords(polygon);
-            if (object->shape() == MapObject::Polygon) {
+            const QPolygonF &screenPolygon = geometry.screenPolygon;
+            if (object->shape() == MapObject::Polygon)
                 path.addPolygon(screenPolygon);
-            } else {
-                for (int i = 1; i < screenPolygon.size(); ++i) {
-                    path.addPolygon(lineToPolygon(screenPolygon[i - 1],
-                                                  screenPolygon[i]));
-                }
-                path.setFillRule(Qt::WindingFill);
-            }
+            else
+                path = polylineShape(screenPolygon);
             break;
         }
         case MapObject::Ellipse: {
@@ -147,6 +149,9 @@ QPainterPath OrthogonalRenderer::shape(const MapObject *object) const
             break;
         }
         }
+
+        geometry.shape = path;
+        geometry.hasShape = true;
     }
 
     return path;
@@ -202,7 +207,8 @@ void OrthogonalRenderer::drawImageLayer(QPainter *painter,
 
 void OrthogonalRenderer::drawTileLayer(QPainter *painter,
                                        const TileLayer *layer,
-                                       const QRectF &exposed) const
+                                       const QRectF &exposed,
+                                       const QList<const TileLayer*> &occluders) const
 {
     QTransform savedTransform = painter->transform();
 
@@ -236,49 +242,25 @@ void OrthogonalRenderer::drawTileLayer(QPainter *painter,
         endY = qMin((int) std::ceil(rect.bottom()) / tileHeight + 1, endY);
     }
 
-    QTransform baseTransform = painter->transform();
+    const bool cullOccluded = !occluders.isEmpty();
 
     for (int y = startY; y < endY; ++y) {
         for (int x = startX; x < endX; ++x) {
             const Cell &cell = layer->cellAt(x, y);
             if (cell.isEmpty())
                 continue;
+            if (cullOccluded && isOccluded(layer, x, y, occluders))
+                continue;
 
-            const QPixmap &img = cell.tile->image();
+            const QPixmap &img = cell.tile->image(cell.flippedHorizontally,
+                                                  cell.flippedVertically,
+                                                  cell.flippedAntiDiagonally);
             const QPoint offset = cell.tile->tileset()->tileOffset();
 
-            qreal m11 = 1;      // Horizontal scaling factor
-            qreal m12 = 0;      // Vertical shearing factor
-            qreal m21 = 0;      // Horizontal shearing factor
-            qreal m22 = 1;      // Vertical scaling factor
-            qreal dx = offset.x() + x * tileWidth;
-            qreal dy = offset.y() + (y + 1) * tileHeight - img.height();
-
-            if (cell.flippedAntiDiagonally) {
-                // Use shearing to swap the X/Y axis
-                m11 = 0;
-                m12 = 1;
-                m21 = 1;
-                m22 = 0;
-
-                // Compensate for the swap of image dimensions
-                dy += img.height() - img.width();
-            }
-            if (cell.flippedHorizontally) {
-                m11 = -m11;
-                m21 = -m21;    
-                dx += cell.flippedAntiDiagonally ? img.height() : img.width();
-            }
-            if (cell.flippedVertically) {
-                m12 = -m12;
-                m22 = -m22;
-                dy += cell.flippedAntiDiagonally ? img.width() : img.height();
-            }
-
-            const QTransform transform(m11, m12, m21, m22, dx, dy);
-            painter->setTransform(transform * baseTransform);
-
-            painter->drawPixmap(0, 0, img);
+            // Flipped images are cached, so no transformation is needed
+            painter->drawPixmap(offset.x() + x * tileWidth,
+                                offset.y() + (y + 1) * tileHeight - img.height(),
+                                img);
         }
     }
 
@@ -53,7 +53,9 @@ public:
                   QColor gridColor) const;
 
     void drawTileLayer(QPainter *painter, const TileLayer *layer,
-                       const QRectF &exposed = QRectF()) const;
+                       const QRectF &exposed = QRectF(),
+                       const QList<const TileLayer*> &occluders =
+                            QList<const TileLayer*>()) const;
 
     void drawTileSelection(QPainter *painter,
                            const QRegion &region,
@@ -0,0 +1,145 @@
+/*
+ * sparsecells.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "sparsecells.h"
+
+using namespace Tiled;
+
+const SparseCells::Chunk *SparseCells::findChunk(int x, int y) const
+{
+    QHash<quint64, QSharedDataPointer<Chunk> >::const_iterator it =
+            mChunks.find(chunkKey(x, y));
+    return it == mChunks.constEnd() ? 0 : it.value().constData();
+}
+
+bool SparseCells::contains(int x, int y) const
+{
+    const Chunk *chunk = findChunk(x, y);
+    return chunk && (chunk->mask & (quint64(1) << cellIndex(x, y)));
+}
+
+Cell SparseCells::cellAt(int x, int y) const
+{
+    const Chunk *chunk = findChunk(x, y);
+    if (!chunk)
+        return Cell();
+    return chunk->cells[cellIndex(x, y)];
+}
+
+void SparseCells::setCell(int x, int y, const Cell &cell)
+{
+    QSharedDataPointer<Chunk> &chunk = mChunks[chunkKey(x, y)];
+    if (!chunk)
+        chunk = new Chunk;
+
+    // Detaches the chunk when it is shared
+    Chunk *data = chunk.data();
+    const int index = cellIndex(x, y);
+    data->cells[index] = cell;
+    data->mask |= quint64(1) << index;
+}
+
+void SparseCells::copyCells(int x, int y, const TileLayer *layer,
+                            const QRegion &region, bool skipEmpty)
+{
+    foreach (const QRect &rect, region.rects()) {
+        for (int _y = rect.top(); _y <= rect.bottom(); ++_y) {
+            for (int _x = rect.left(); _x <= rect.right(); ++_x) {
+                Cell cell;
+                if (layer->contains(_x - x, _y - y))
+                    cell = layer->cellAt(_x - x, _y - y);
+                if (skipEmpty && cell.isEmpty())
+                    continue;
+
+                setCell(_x, _y, cell);
+            }
+        }
+    }
+}
+
+void SparseCells::merge(const SparseCells &other)
+{
+    QHash<quint64, QSharedDataPointer<Chunk> >::const_iterator it =
+            other.mChunks.constBegin();
+    QHash<quint64, QSharedDataPointer<Chunk> >::const_iterator it_end =
+            other.mChunks.constEnd();
+
+    for (; it != it_end; ++it) {
+        QSharedDataPointer<Chunk> &chunk = mChunks[it.key()];
+
+        // Share the chunks that we don't have yet
+        if (!chunk) {
+            chunk = it.value();
+            continue;
+        }
+
+        const Chunk *source = it.value().constData();
+        Chunk *data = chunk.data();
+        for (int index = 0; index < ChunkSize * ChunkSize; ++index) {
+            const quint64 bit = quint64(1) << index;
+            if (source->mask & bit)
+                data->cells[index] = source->cells[index];
+        }
+        data->mask |= source->mask;
+    }
+}
+
+void SparseCells::merge(const SparseCells &other, const QRegion &region)
+{
+    foreach (const QRect &rect, region.rects())
+        for (int y = rect.top(); y <= rect.bottom(); ++y)
+            for (int x = rect.left(); x <= rect.right(); ++x)
+                if (const Chunk *chunk = other.findChunk(x, y))
+                    if (chunk->mask & (quint64(1) << cellIndex(x, y)))
+                        setCell(x, y, chunk->cells[cellIndex(x, y)]);
+}
+
+void SparseCells::apply(TileLayer *layer, const QRegion &region) const
+{
+    const int layerX = layer->x();
+    const int layerY = layer->y();
+
+    foreach (const QRect &rect, region.rects()) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                const Chunk *chunk = findChunk(x, y);
+                if (!chunk)
+                    continue;
+
+                const int index = cellIndex(x, y);
+                if (!(chunk->mask & (quint64(1) << index)))
+                    continue;
+
+                if (layer->contains(x - layerX, y - layerY))
+                    layer->setCell(x - layerX, y - layerY,
+                                   chunk->cells[index]);
+            }
+        }
+    }
+}
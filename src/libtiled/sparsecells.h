@@ -0,0 +1,146 @@
+/*
+ * sparsecells.h
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef SPARSECELLS_H
+#define SPARSECELLS_H
+
+#include "tilelayer.h"
+
+#include <QHash>
+#include <QRegion>
+#include <QSharedData>
+#include <QSharedDataPointer>
+
+namespace Tiled {
+
+/**
+ * A sparse set of cells at arbitrary positions, stored in chunks of 8x8
+ * cells. Only the chunks in which cells were stored take up memory, which
+ * makes it suitable for remembering the cells touched by an edit.
+ *
+ * The chunks are implicitly shared, so copying or merging a set of cells
+ * only copies the chunks once they are changed.
+ */
+class TILEDSHARED_EXPORT SparseCells
+{
+public:
+    /**
+     * Returns whether no cell is stored.
+     */
+    bool isEmpty() const { return mChunks.isEmpty(); }
+
+    /**
+     * Returns the number of chunks used to store the cells.
+     */
+    int chunkCount() const { return mChunks.size(); }
+
+    /**
+     * Returns the approximate number of bytes used to store the cells.
+     */
+    qint64 memoryUsage() const
+    { return qint64(mChunks.size()) * sizeof(Chunk); }
+
+    /**
+     * Returns whether a cell is stored at the given position.
+     */
+    bool contains(int x, int y) const;
+
+    /**
+     * Returns the cell stored at the given position, or an empty cell when
+     * there is none.
+     */
+    Cell cellAt(int x, int y) const;
+
+    /**
+     * Stores the \a cell at the given position.
+     */
+    void setCell(int x, int y, const Cell &cell);
+
+    /**
+     * Stores the cells of \a layer, placed at \a x, \a y, that fall within
+     * \a region. Positions outside of the layer are stored as empty cells,
+     * unless \a skipEmpty is true, in which case empty cells are not stored.
+     */
+    void copyCells(int x, int y, const TileLayer *layer,
+                   const QRegion &region, bool skipEmpty = false);
+
+    /**
+     * Stores all cells of \a other, replacing any cells stored at the same
+     * positions.
+     */
+    void merge(const SparseCells &other);
+
+    /**
+     * Stores the cells of \a other that fall within \a region, replacing any
+     * cells stored at the same positions.
+     */
+    void merge(const SparseCells &other, const QRegion &region);
+
+    /**
+     * Sets the stored cells that fall within \a region on the given
+     * \a layer, taking into account the position of the layer.
+     */
+    void apply(TileLayer *layer, const QRegion &region) const;
+
+private:
+    enum {
+        ChunkShift = 3,
+        ChunkSize = 1 << ChunkShift,
+        ChunkMask = ChunkSize - 1
+    };
+
+    /**
+     * A square of cells, with a bit for each cell that is stored.
+     */
+    class Chunk : public QSharedData
+    {
+    public:
+        Chunk() : mask(0) {}
+
+        quint64 mask;
+        Cell cells[ChunkSize * ChunkSize];
+    };
+
+    static quint64 chunkKey(int x, int y)
+    {
+        return (quint64(quint32(x >> ChunkShift)) << 32)
+                | quint32(y >> ChunkShift);
+    }
+
+    static int cellIndex(int x, int y)
+    { return ((y & ChunkMask) << ChunkShift) | (x & ChunkMask); }
+
+    const Chunk *findChunk(int x, int y) const;
+
+    QHash<quint64, QSharedDataPointer<Chunk> > mChunks;
+};
+
+} // namespace Tiled
+
+#endif // SPARSECELLS_H
@@ -125,7 +125,8 @@ void StaggeredRenderer::drawGrid(QPainter *painter, const QRectF &rect,
 
 void StaggeredRenderer::drawTileLayer(QPainter *painter,
                                       const TileLayer *layer,
-                                      const QRectF &exposed) const
+                                      const QRectF &exposed,
+                                      const QList<const TileLayer*> &occluders) const
 {
     const int tileWidth = map()->tileWidth();
     const int tileHeight = map()->tileHeight();
@@ -175,7 +176,7 @@ void StaggeredRenderer::drawTileLayer(QPainter *painter,
 
     qDebug() << rect << startTile << startPos << layer->position();
 
-    QTransform baseTransform = painter->transform();
+    const bool cullOccluded = !occluders.isEmpty();
 
     for (; startPos.y() < rect.bottom() && startTile.y() < layer->height(); startTile.ry()++) {
         QPoint rowTile = startTile;
@@ -186,56 +187,27 @@ void StaggeredRenderer::drawTileLayer(QPainter *painter,
 
         for (; rowPos.x() < rect.right() && rowTile.x() < layer->width(); rowTile.rx()++) {
             const Cell &cell = layer->cellAt(rowTile);
-            if (cell.isEmpty()) {
+            if (cell.isEmpty() || (cullOccluded &&
+                    isOccluded(layer, rowTile.x(), rowTile.y(), occluders))) {
                 rowPos.rx() += tileWidth;
                 continue;
             }
 
-            const QPixmap &img = cell.tile->image();
+            const QPixmap &img = cell.tile->image(cell.flippedHorizontally,
+                                                  cell.flippedVertically,
+                                                  cell.flippedAntiDiagonally);
             const QPoint offset = cell.tile->tileset()->tileOffset();
 
-            qreal m11 = 1;      // Horizontal scaling factor
-            qreal m12 = 0;      // Vertical shearing factor
-            qreal m21 = 0;      // Horizontal shearing factor
-            qreal m22 = 1;      // Vertical scaling factor
-            qreal dx = offset.x() + rowPos.x();
-            qreal dy = offset.y() + rowPos.y() - img.height();
-
-            if (cell.flippedAntiDiagonally) {
-                // Use shearing to swap the X/Y axis
-                m11 = 0;
-                m12 = 1;
-                m21 = 1;
-                m22 = 0;
-
-                // Compensate for the swap of image dimensions
-                dy += img.height() - img.width();
-            }
-            if (cell.flippedHorizontally) {
-                m11 = -m11;
-                m21 = -m21;
-                dx += cell.flippedAntiDiagonally ? img.height()
-                                                 : img.width();
-            }
-            if (cell.flippedVertically) {
-                m12 = -m12;
-                m22 = -m22;
-                dy += cell.flippedAntiDiagonally ? img.width()
-                                                 : img.height();
-            }
-
-            const QTransform transform(m11, m12, m21, m22, dx, dy);
-            painter->setTransform(transform * baseTransform);
-
-            painter->drawPixmap(0, 0, img);
+            // Flipped images are cached, so no transformation is needed
+            painter->drawPixmap(offset.x() + rowPos.x(),
+                                offset.y() + rowPos.y() - img.height(),
+                                img);
 
             rowPos.rx() += tileWidth;
         }
 
         startPos.ry() += tileHeight / 2;
     }
-
-    painter->setTransform(baseTransform);
 }
 
 void StaggeredRenderer::drawTileSelection(QPainter *painter,
@@ -0,0 +1,66 @@
+/*
+ * tile.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tile.h"
+
+#include <QImage>
+#include <QTransform>
+
+using namespace Tiled;
+
+const QPixmap &Tile::image(bool flippedHorizontally,
+                           bool flippedVertically,
+                           bool flippedAntiDiagonally) const
+{
+    const int orientation = (flippedHorizontally << 2) |
+                            (flippedVertically << 1) |
+                            (flippedAntiDiagonally << 0);
+
+    if (orientation == 0 || mImage.isNull())
+        return mImage;
+
+    if (mFlippedImages.isEmpty())
+        mFlippedImages.resize(8);
+
+    QPixmap &flipped = mFlippedImages[orientation];
+    if (flipped.isNull()) {
+        QImage image = mImage.toImage();
+        bool mirrorHorizontally = flippedHorizontally;
+
+        // Swapping the X/Y axis is a rotation followed by a mirror
+        if (flippedAntiDiagonally) {
+            image = image.transformed(QTransform().rotate(90));
+            mirrorHorizontally = !mirrorHorizontally;
+        }
+
+        flipped = QPixmap::fromImage(image.mirrored(mirrorHorizontally,
+                                                    flippedVertically));
+    }
+
+    return flipped;
+}
@@ -34,6 +34,7 @@
 #include "tileset.h"
 
 #include <QPixmap>
+#include <QVector>
 
 namespace Tiled {
 
@@ -44,6 +45,7 @@ public:
         mId(id),
         mTileset(tileset),
         mImage(image),
+        mOpaque(false),
         mTerrain(-1),
         mTerrainProbability(-1.f)
     {}
@@ -66,7 +68,22 @@ public:
     /**
      * Sets the image of this tile.
      */
-    void setImage(const QPixmap &image) { mImage = image; }
+    void setImage(const QPixmap &image)
+    {
+        mImage = image;
+        mFlippedImages.clear();
+    }
+
+    /**
+     * Returns the image of this tile in the given orientation. The flipped
+     * images are created on demand and cached, so that flipped tiles can be
+     * drawn without a transformation.
+     *
+     * The anti-diagonal flip is applied first, like when rendering a cell.
+     */
+    const QPixmap &image(bool flippedHorizontally,
+                         bool flippedVertically,
+                         bool flippedAntiDiagonally) const;
 
     /**
      * Returns the width of this tile.
@@ -83,6 +100,19 @@ public:
      */
     QSize size() const { return mImage.size(); }
 
+    /**
+     * Returns whether the image of this tile is fully opaque. Opaque tiles
+     * hide whatever is drawn below them, which allows renderers to skip
+     * drawing those parts.
+     */
+    bool isOpaque() const { return mOpaque; }
+
+    /**
+     * Sets whether the image of this tile is fully opaque. This is determined
+     * by the tileset when loading the tile images.
+     */
+    void setOpaque(bool opaque) { mOpaque = opaque; }
+
     /**
      * Returns the Terrain of a given corner.
      */
@@ -126,6 +156,8 @@ private:
     int mId;
     Tileset *mTileset;
     QPixmap mImage;
+    mutable QVector<QPixmap> mFlippedImages;
+    bool mOpaque;
     unsigned int mTerrain;
     float mTerrainProbability;
 };
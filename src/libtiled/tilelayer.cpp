@@ -34,6 +34,8 @@
 #include "tile.h"
 #include "tileset.h"
 
+#include <QtAlgorithms>
+
 using namespace Tiled;
 
 TileLayer::TileLayer(const QString &name, int x, int y, int width, int height):
@@ -68,6 +70,27 @@ QRegion TileLayer::region() const
     return region;
 }
 
+OccupancyBitmap TileLayer::occupancy() const
+{
+    OccupancyBitmap occupancy;
+
+    for (int y = 0; y < mHeight; ++y) {
+        int rangeStart = -1;
+        for (int x = 0; x <= mWidth; ++x) {
+            const bool empty = x == mWidth || cellAt(x, y).isEmpty();
+            if (!empty && rangeStart == -1) {
+                rangeStart = x;
+            } else if (empty && rangeStart != -1) {
+                occupancy.add(QRect(rangeStart + mX, y + mY,
+                                    x - rangeStart, 1));
+                rangeStart = -1;
+            }
+        }
+    }
+
+    return occupancy;
+}
+
 static QSize maxSize(const QSize &a,
                      const QSize &b)
 {
@@ -176,26 +199,46 @@ void TileLayer::erase(const QRegion &area)
 
 void TileLayer::flip(FlipDirection direction)
 {
-    QVector<Cell> newGrid(mWidth * mHeight);
-
     Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
 
-    for (int y = 0; y < mHeight; ++y) {
-        for (int x = 0; x < mWidth; ++x) {
-            Cell &dest = newGrid[x + y * mWidth];
-            if (direction == FlipHorizontally) {
-                const Cell &source = cellAt(mWidth - x - 1, y);
-                dest = source;
-                dest.flippedHorizontally = !source.flippedHorizontally;
-            } else if (direction == FlipVertically) {
-                const Cell &source = cellAt(x, mHeight - y - 1);
-                dest = source;
-                dest.flippedVertically = !source.flippedVertically;
-            }
+    Cell *grid = mGrid.data();
+    Cell *gridEnd = grid + mGrid.size();
+
+    if (direction == FlipHorizontally) {
+        for (int y = 0; y < mHeight; ++y) {
+            Cell *left = grid + y * mWidth;
+            Cell *right = left + mWidth - 1;
+            for (; left < right; ++left, --right)
+                qSwap(*left, *right);
         }
+
+        for (Cell *cell = grid; cell != gridEnd; ++cell)
+            cell->flippedHorizontally = !cell->flippedHorizontally;
+    } else {
+        for (int y = 0; y < mHeight / 2; ++y) {
+            Cell *top = grid + y * mWidth;
+            Cell *bottom = grid + (mHeight - y - 1) * mWidth;
+            for (int x = 0; x < mWidth; ++x)
+                qSwap(top[x], bottom[x]);
+        }
+
+        for (Cell *cell = grid; cell != gridEnd; ++cell)
+            cell->flippedVertically = !cell->flippedVertically;
     }
+}
 
-    mGrid = newGrid;
+static inline void rotateFlags(Cell &cell, const char (&rotateMask)[8])
+{
+    unsigned char mask =
+            (cell.flippedHorizontally << 2) |
+            (cell.flippedVertically << 1) |
+            (cell.flippedAntiDiagonally << 0);
+
+    mask = rotateMask[mask];
+
+    cell.flippedHorizontally = (mask & 4) != 0;
+    cell.flippedVertically = (mask & 2) != 0;
+    cell.flippedAntiDiagonally = (mask & 1) != 0;
 }
 
 void TileLayer::rotate(RotateDirection direction)
@@ -210,26 +253,39 @@ void TileLayer::rotate(RotateDirection direction)
     int newHeight = mWidth;
     QVector<Cell> newGrid(newWidth * newHeight);
 
-    for (int y = 0; y < mHeight; ++y) {
-        for (int x = 0; x < mWidth; ++x) {
-            const Cell &source = cellAt(x, y);
-            Cell dest = source;
+    const Cell *source = mGrid.constData();
+    Cell *dest = newGrid.data();
+
+    // Each column of the layer becomes a row of the rotated layer. This is
+    // done in blocks, so that the rows read for a block stay in the cache.
+    const int blockSize = 32;
 
-            unsigned char mask =
-                    (dest.flippedHorizontally << 2) |
-                    (dest.flippedVertically << 1) |
-                    (dest.flippedAntiDiagonally << 0);
+    for (int blockY = 0; blockY < mHeight; blockY += blockSize) {
+        const int endY = qMin(blockY + blockSize, mHeight);
 
-            mask = rotateMask[mask];
+        for (int blockX = 0; blockX < mWidth; blockX += blockSize) {
+            const int endX = qMin(blockX + blockSize, mWidth);
 
-            dest.flippedHorizontally = (mask & 4) != 0;
-            dest.flippedVertically = (mask & 2) != 0;
-            dest.flippedAntiDiagonally = (mask & 1) != 0;
+            for (int x = blockX; x < endX; ++x) {
+                const Cell *sourceCell = source + x + blockY * mWidth;
+                Cell *destCell;
+                int step;
+
+                if (direction == RotateRight) {
+                    destCell = dest + x * newWidth + (mHeight - blockY - 1);
+                    step = -1;
+                } else {
+                    destCell = dest + (mWidth - x - 1) * newWidth + blockY;
+                    step = 1;
+                }
 
-            if (direction == RotateRight)
-                newGrid[x * newWidth + (mHeight - y - 1)] = dest;
-            else
-                newGrid[(mWidth - x - 1) * newWidth + y] = dest;
+                for (int y = blockY; y < endY; ++y) {
+                    *destCell = *sourceCell;
+                    rotateFlags(*destCell, rotateMask);
+                    sourceCell += mWidth;
+                    destCell += step;
+                }
+            }
         }
     }
 
@@ -305,10 +361,14 @@ void TileLayer::resize(const QSize &size, const QPoint &offset)
     const int endX = qMin(mWidth, size.width() - offset.x());
     const int endY = qMin(mHeight, size.height() - offset.y());
 
-    for (int y = startY; y < endY; ++y) {
-        for (int x = startX; x < endX; ++x) {
-            const int index = x + offset.x() + (y + offset.y()) * size.width();
-            newGrid[index] = cellAt(x, y);
+    if (startX < endX) {
+        const Cell *source = mGrid.constData();
+        Cell *dest = newGrid.data();
+
+        for (int y = startY; y < endY; ++y) {
+            const Cell *row = source + startX + y * mWidth;
+            qCopy(row, row + endX - startX,
+                  dest + startX + offset.x() + (y + offset.y()) * size.width());
         }
     }
 
@@ -316,49 +376,150 @@ void TileLayer::resize(const QSize &size, const QPoint &offset)
     Layer::resize(size, offset);
 }
 
+/**
+ * Writes \a count cells to \a dest, taken from the row of \a size cells at
+ * \a source starting at index \a start. Indexes outside of the row wrap
+ * around when \a wrap is true, and result in empty cells otherwise.
+ */
+static void copyRow(const Cell *source, int size, int start, bool wrap,
+                    Cell *dest, int count)
+{
+    if (wrap) {
+        start %= size;
+        if (start < 0)
+            start += size;
+
+        while (count > 0) {
+            const int n = qMin(count, size - start);
+            qCopy(source + start, source + start + n, dest);
+            dest += n;
+            count -= n;
+            start = 0;
+        }
+        return;
+    }
+
+    const int before = qBound(0, -start, count);
+    qFill(dest, dest + before, Cell());
+    dest += before;
+    count -= before;
+    start += before;
+
+    const int n = qBound(0, size - start, count);
+    qCopy(source + start, source + start + n, dest);
+    qFill(dest + n, dest + count, Cell());
+}
+
+static int greatestCommonDivisor(int a, int b)
+{
+    while (b != 0) {
+        const int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
 void TileLayer::offset(const QPoint &offset,
                        const QRect &bounds,
                        bool wrapX, bool wrapY)
 {
-    QVector<Cell> newGrid(mWidth * mHeight);
+    // Only the part of the bounds that lies within the layer has any cells.
+    // Any other part of the bounds behaves like it is filled with empty cells.
+    const QRect area = bounds & QRect(0, 0, mWidth, mHeight);
+    if (area.isEmpty())
+        return;
+
+    Cell *grid = mGrid.data();
+    const int areaWidth = area.width();
+
+    // Buffer holding one row of the bounds
+    QVector<Cell> buffer(bounds.width());
+    Cell *row = buffer.data();
+
+    // Shift the cells of each row horizontally
+    const int dx = offset.x();
+    if (dx != 0 && !(wrapX && dx % bounds.width() == 0)) {
+        const int start = area.left() - bounds.left();
+
+        for (int y = area.top(); y <= area.bottom(); ++y) {
+            Cell *cells = grid + area.left() + y * mWidth;
+            qCopy(cells, cells + areaWidth, row + start);
+            copyRow(row, bounds.width(), start - dx, wrapX, cells, areaWidth);
+        }
+    }
 
-    for (int y = 0; y < mHeight; ++y) {
-        for (int x = 0; x < mWidth; ++x) {
-            // Skip out of bounds tiles
-            if (!bounds.contains(x, y)) {
-                newGrid[x + y * mWidth] = cellAt(x, y);
-                continue;
+    // Move the rows vertically. Only the part of each row within the area
+    // is moved, since the rest of the row is not affected.
+    const int dy = offset.y();
+    const int height = bounds.height();
+    Cell *areaGrid = grid + area.left();
+
+    if (wrapY) {
+        int shift = dy % height;
+        if (shift < 0)
+            shift += height;
+        if (shift == 0)
+            return;
+
+        // Rotate the rows of the bounds, following each cycle of rows that
+        // replace each other and using the buffer for the first row
+        const int cycleCount = greatestCommonDivisor(height, shift);
+        for (int first = 0; first < cycleCount; ++first) {
+            const int firstY = bounds.top() + first;
+            if (area.contains(area.left(), firstY)) {
+                Cell *cells = areaGrid + firstY * mWidth;
+                qCopy(cells, cells + areaWidth, row);
+            } else {
+                qFill(row, row + areaWidth, Cell());
             }
 
-            // Get position to pull tile value from
-            int oldX = x - offset.x();
-            int oldY = y - offset.y();
+            int target = first;
+            for (;;) {
+                int source = target - shift;
+                if (source < 0)
+                    source += height;
+
+                const int targetY = bounds.top() + target;
+                const int sourceY = bounds.top() + source;
+
+                if (area.contains(area.left(), targetY)) {
+                    Cell *cells = areaGrid + targetY * mWidth;
+
+                    if (source == first) {
+                        qCopy(row, row + areaWidth, cells);
+                    } else if (area.contains(area.left(), sourceY)) {
+                        const Cell *sourceCells = areaGrid + sourceY * mWidth;
+                        qCopy(sourceCells, sourceCells + areaWidth, cells);
+                    } else {
+                        qFill(cells, cells + areaWidth, Cell());
+                    }
+                }
 
-            // Wrap x value that will be pulled from
-            if (wrapX && bounds.width() > 0) {
-                while (oldX < bounds.left())
-                    oldX += bounds.width();
-                while (oldX > bounds.right())
-                    oldX -= bounds.width();
+                if (source == first)
+                    break;
+                target = source;
             }
-
-            // Wrap y value that will be pulled from
-            if (wrapY && bounds.height() > 0) {
-                while (oldY < bounds.top())
-                    oldY += bounds.height();
-                while (oldY > bounds.bottom())
-                    oldY -= bounds.height();
+        }
+    } else if (dy != 0) {
+        // Walk against the direction of the shift, so that each row is
+        // moved before it is overwritten
+        const int step = dy > 0 ? -1 : 1;
+        const int begin = dy > 0 ? area.bottom() : area.top();
+        const int end = dy > 0 ? area.top() - 1 : area.bottom() + 1;
+
+        for (int y = begin; y != end; y += step) {
+            Cell *cells = areaGrid + y * mWidth;
+            const int sourceY = y - dy;
+
+            if (sourceY >= area.top() && sourceY <= area.bottom()) {
+                const Cell *sourceCells = areaGrid + sourceY * mWidth;
+                qCopy(sourceCells, sourceCells + areaWidth, cells);
+            } else {
+                qFill(cells, cells + areaWidth, Cell());
             }
-
-            // Set the new tile
-            if (contains(oldX, oldY) && bounds.contains(oldX, oldY))
-                newGrid[x + y * mWidth] = cellAt(oldX, oldY);
-            else
-                newGrid[x + y * mWidth] = Cell();
         }
     }
-
-    mGrid = newGrid;
 }
 
 bool TileLayer::canMergeWith(Layer *other) const
@@ -382,27 +543,39 @@ Layer *TileLayer::mergedWith(Layer *other) const
 
 QRegion TileLayer::computeDiffRegion(const TileLayer *other) const
 {
-    QRegion ret;
-
     const int dx = other->x() - mX;
     const int dy = other->y() - mY;
     QRect r = QRect(0, 0, width(), height());
     r &= QRect(dx, dy, other->width(), other->height());
 
+    // Rows are compared in order, so the runs are sorted the way setRects()
+    // expects them
+    QVector<QRect> runs;
+    const int count = r.width();
+
     for (int y = r.top(); y <= r.bottom(); ++y) {
-        for (int x = r.left(); x <= r.right(); ++x) {
-            if (cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
-                const int rangeStart = x;
-                while (x <= r.right() &&
-                       cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
-                    ++x;
-                }
-                const int rangeEnd = x;
-                ret += QRect(rangeStart, y, rangeEnd - rangeStart, 1);
-            }
+        const Cell *cells = mGrid.constData() + r.left() + y * mWidth;
+        const Cell *otherCells = other->mGrid.constData()
+                + (r.left() - dx) + (y - dy) * other->mWidth;
+
+        int i = 0;
+        while (i < count) {
+            while (i < count && cells[i] == otherCells[i])
+                ++i;
+            if (i == count)
+                break;
+
+            const int rangeStart = i;
+            while (i < count && cells[i] != otherCells[i])
+                ++i;
+
+            runs.append(QRect(r.left() + rangeStart, y, i - rangeStart, 1));
         }
     }
 
+    QRegion ret;
+    if (!runs.isEmpty())
+        ret.setRects(runs.constData(), runs.size());
     return ret;
 }
 
@@ -422,7 +595,11 @@ bool TileLayer::isEmpty() const
  */
 Layer *TileLayer::clone() const
 {
-    return initializeClone(new TileLayer(mName, mX, mY, mWidth, mHeight));
+    // The cells are shared with the clone, so don't allocate any for it
+    TileLayer *clone = new TileLayer(mName, mX, mY, 0, 0);
+    clone->mWidth = mWidth;
+    clone->mHeight = mHeight;
+    return initializeClone(clone);
 }
 
 TileLayer *TileLayer::initializeClone(TileLayer *clone) const
@@ -33,6 +33,7 @@
 #include "tiled_global.h"
 
 #include "layer.h"
+#include "occupancybitmap.h"
 
 #include <QMargins>
 #include <QString>
@@ -147,6 +148,12 @@ public:
      */
     QRegion region() const;
 
+    /**
+     * Returns the positions occupied by the tiles of this layer as a bitmap.
+     * Faster than region() for when only membership needs to be tested.
+     */
+    OccupancyBitmap occupancy() const;
+
     /**
      * Returns a read-only reference to the cell at the given coordinates. The
      * coordinates have to be within this layer.
@@ -242,8 +249,11 @@ public:
     virtual void resize(const QSize &size, const QPoint &offset);
 
     /**
-     * Offsets the objects in this group by \a offset, within \bounds
-     * and optionally wraps it.
+     * Offsets the tiles in this layer by \a offset, within \a bounds
+     * and optionally wraps them. Tiles that are moved out of the bounds
+     * without wrapping are lost, and the vacated positions are cleared.
+     *
+     * The tiles are moved in place, a row at a time.
      *
      * \sa Layer::offset()
      */
@@ -33,6 +33,8 @@
 
 #include <QBitmap>
 
+#include <climits>
+
 using namespace Tiled;
 
 Tileset::~Tileset()
@@ -40,6 +42,33 @@ Tileset::~Tileset()
     qDeleteAll(mTiles);
 }
 
+/**
+ * Returns whether all pixels of the given tile \a image are fully opaque,
+ * taking into account the given \a transparentColor.
+ */
+static bool isFullyOpaque(const QImage &image, const QColor &transparentColor)
+{
+    if (!image.hasAlphaChannel() && !transparentColor.isValid())
+        return true;
+
+    const QImage argb = image.convertToFormat(QImage::Format_ARGB32);
+    const QRgb transparentRgb = transparentColor.isValid()
+            ? (transparentColor.rgb() | 0xff000000) : 0;
+
+    for (int y = 0; y < argb.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb*>(argb.scanLine(y));
+        for (int x = 0; x < argb.width(); ++x) {
+            if (qAlpha(line[x]) != 255)
+                return false;
+            if (transparentColor.isValid() &&
+                    (line[x] | 0xff000000) == transparentRgb)
+                return false;
+        }
+    }
+
+    return true;
+}
+
 Tile *Tileset::tileAt(int id) const
 {
     return (id < mTiles.size()) ? mTiles.at(id) : 0;
@@ -74,6 +103,8 @@ bool Tileset::loadFromImage(const QImage &image, const QString &fileName)
             } else {
                 mTiles.append(new Tile(tilePixmap, tileNum, this));
             }
+            mTiles.at(tileNum)->setOpaque(isFullyOpaque(tileImage,
+                                                        mTransparentColor));
             ++tileNum;
         }
     }
@@ -83,6 +114,7 @@ bool Tileset::loadFromImage(const QImage &image, const QString &fileName)
         QPixmap tilePixmap = QPixmap(mTileWidth, mTileHeight);
         tilePixmap.fill();
         mTiles.at(tileNum)->setImage(tilePixmap);
+        mTiles.at(tileNum)->setOpaque(true);
         ++tileNum;
     }
 
@@ -90,6 +122,7 @@ bool Tileset::loadFromImage(const QImage &image, const QString &fileName)
     mImageHeight = image.height();
     mColumnCount = columnCountForWidth(mImageWidth);
     mImageSource = fileName;
+    clearTerrainIndex();
     return true;
 }
 
@@ -117,6 +150,7 @@ int Tileset::columnCountForWidth(int width) const
 void Tileset::addTerrain(Terrain *terrain)
 {
     mTerrainTypes.push_back(terrain);
+    clearTerrainIndex();
 }
 
 int Tileset::terrainTransitionPenalty(int terrainType0, int terrainType1)
@@ -138,6 +172,9 @@ void Tileset::calculateTerrainDistances()
     #define hasZeroByte(dword) (((dword) - 0x01010101UL) & ~(dword) & 0x80808080UL)
     #define hasByteEqualTo(dword, value) (hasZeroByte((dword) ^ (~0UL/255 * (value))))
 
+    // The terrain of the tiles may have changed
+    clearTerrainIndex();
+
     // Calculate terrain distances if they are not already present...
     // Terrain distances are the number of transitions required before one terrain may meet another
     // Terrains that have no transition path have a distance of -1
@@ -219,3 +256,137 @@ void Tileset::calculateTerrainDistances()
         // Repeat while we are still making new connections (could take a number of iterations for distant terrain types to connect)
     } while (bNewConnections);
 }
+
+Tile *TerrainCandidates::tileAt(float percentile) const
+{
+    const QVector<float>::const_iterator it =
+            qUpperBound(cumulativeProbabilities.begin(),
+                        cumulativeProbabilities.end(),
+                        percentile);
+
+    if (it == cumulativeProbabilities.end())
+        return 0;
+
+    return tiles.at(it - cumulativeProbabilities.begin());
+}
+
+TerrainCandidates Tileset::terrainCandidates(unsigned int terrain,
+                                             unsigned int considerationMask)
+{
+    const quint64 key = quint64(terrain) << 32 | considerationMask;
+    QMutexLocker locker(&mTerrainIndexMutex);
+
+    QHash<quint64, TerrainCandidates>::iterator it =
+            mTerrainCandidates.find(key);
+    if (it == mTerrainCandidates.end())
+        it = mTerrainCandidates.insert(key, findTerrainCandidates(
+                                           terrain, considerationMask));
+
+    return it.value();
+}
+
+TerrainCandidates Tileset::findTerrainCandidates(unsigned int terrain,
+                                                 unsigned int considerationMask)
+{
+    TerrainCandidates candidates;
+    QVector<Tile*> matches;
+    int penalty = INT_MAX;
+
+    const QVector<Tile*> tiles =
+            terrainIndex(considerationMask).value(terrain & considerationMask);
+
+    foreach (Tile *t, tiles) {
+        // calculate the tile transition penalty based on shortest distance to target terrain type
+        int transitionPenalty = 0;
+        for (int corner = 0; corner < 4; ++corner) {
+            const int shift = (3 - corner) * 8;
+            const int cornerPenalty = terrainTransitionPenalty(
+                        (t->terrain() >> shift) & 0xFF,
+                        (terrain >> shift) & 0xFF);
+
+            // if there is no path to the destination terrain, this isn't a useful transition
+            if (cornerPenalty < 0) {
+                transitionPenalty = -1;
+                break;
+            }
+            transitionPenalty += cornerPenalty;
+        }
+        if (transitionPenalty < 0)
+            continue;
+
+        // add tile to the candidate list
+        if (transitionPenalty <= penalty) {
+            if (transitionPenalty < penalty)
+                matches.clear();
+            penalty = transitionPenalty;
+
+            matches.append(t);
+        }
+    }
+
+    if (matches.isEmpty())
+        return candidates;
+
+    candidates.penalty = penalty;
+    candidates.tiles.reserve(matches.size());
+    candidates.cumulativeProbabilities.reserve(matches.size());
+
+    // allow the tiles with assigned probability to take their share
+    float total = 0;
+    int unassigned = 0;
+    foreach (Tile *t, matches) {
+        const float probability = t->terrainProbability();
+        if (probability < 0.f) {
+            ++unassigned;
+            continue;
+        }
+        total += probability;
+        candidates.tiles.append(t);
+        candidates.cumulativeProbabilities.append(total);
+    }
+
+    // divide the remaining percentile by the number of unassigned tiles
+    if (unassigned > 0) {
+        const float remainingShare = (100.f - total) / (float)unassigned;
+        foreach (Tile *t, matches) {
+            if (t->terrainProbability() >= 0.f)
+                continue;
+            // when the assigned tiles took more than their share, the
+            // remaining tiles are never chosen
+            total = qMax(total, total + remainingShare);
+            candidates.tiles.append(t);
+            candidates.cumulativeProbabilities.append(total);
+        }
+    }
+
+    return candidates;
+}
+
+/**
+ * Returns the tiles of this tileset grouped by their terrain masked with the
+ * given \a considerationMask. The grouping is created on first use.
+ */
+const QHash<unsigned int, QVector<Tile*> > &
+Tileset::terrainIndex(unsigned int considerationMask)
+{
+    QHash<unsigned int, QHash<unsigned int, QVector<Tile*> > >::iterator it =
+            mTerrainIndex.find(considerationMask);
+
+    if (it == mTerrainIndex.end()) {
+        it = mTerrainIndex.insert(considerationMask,
+                                  QHash<unsigned int, QVector<Tile*> >());
+
+        QHash<unsigned int, QVector<Tile*> > &index = it.value();
+        foreach (Tile *t, mTiles)
+            index[t->terrain() & considerationMask].append(t);
+    }
+
+    return it.value();
+}
+
+void Tileset::clearTerrainIndex()
+{
+    QMutexLocker locker(&mTerrainIndexMutex);
+    mTerrainIndex.clear();
+    mTerrainCandidates.clear();
+}
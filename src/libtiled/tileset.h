@@ -33,7 +33,9 @@
 #include "object.h"
 
 #include <QColor>
+#include <QHash>
 #include <QList>
+#include <QMutex>
 #include <QVector>
 #include <QPoint>
 #include <QString>
@@ -45,6 +47,40 @@ namespace Tiled {
 class Tile;
 class Terrain;
 
+/**
+ * The tiles of a tileset that best match a certain terrain pattern, together
+ * with the cumulative terrain probabilities used to choose between them.
+ */
+class TILEDSHARED_EXPORT TerrainCandidates
+{
+public:
+    TerrainCandidates() : penalty(-1) {}
+
+    bool isEmpty() const { return tiles.isEmpty(); }
+
+    /**
+     * Returns the candidate covering the given \a percentile (0-100) of the
+     * probability distribution, or 0 when no candidate covers it.
+     */
+    Tile *tileAt(float percentile) const;
+
+    /**
+     * The matching tiles. Tiles with an assigned terrain probability come
+     * first, followed by the tiles sharing the remaining probability.
+     */
+    QVector<Tile*> tiles;
+
+    /**
+     * For each tile, the percentile up to which it is chosen.
+     */
+    QVector<float> cumulativeProbabilities;
+
+    /**
+     * The transition penalty shared by all candidates.
+     */
+    int penalty;
+};
+
 /**
  * A tileset, representing a set of tiles.
  *
@@ -240,7 +276,27 @@ public:
      */
     int terrainTransitionPenalty(int terrainType0, int terrainType1);
 
+    /**
+     * Returns the tiles that match \a terrain on the corners selected by
+     * \a considerationMask, and that have the lowest transition penalty to
+     * \a terrain on all corners.
+     *
+     * The candidates are looked up in an index that is built on demand and
+     * reset by calculateTerrainDistances(), which needs to be called again
+     * after changing the terrain or probability of any tile.
+     *
+     * This function may be called from multiple threads at once.
+     */
+    TerrainCandidates terrainCandidates(unsigned int terrain,
+                                        unsigned int considerationMask);
+
 private:
+    TerrainCandidates findTerrainCandidates(unsigned int terrain,
+                                            unsigned int considerationMask);
+    const QHash<unsigned int, QVector<Tile*> > &
+            terrainIndex(unsigned int considerationMask);
+    void clearTerrainIndex();
+
     QString mName;
     QString mFileName;
     QString mImageSource;
@@ -255,6 +311,17 @@ private:
     int mColumnCount;
     QList<Tile*> mTiles;
     QList<Terrain*> mTerrainTypes;
+
+    /**
+     * For each consideration mask, the tiles by their masked terrain.
+     */
+    QHash<unsigned int, QHash<unsigned int, QVector<Tile*> > > mTerrainIndex;
+
+    /**
+     * The candidates by terrain (high 32 bits) and consideration mask.
+     */
+    QHash<quint64, TerrainCandidates> mTerrainCandidates;
+    QMutex mTerrainIndexMutex;
 };
 
 } // namespace Tiled
@@ -3,4 +3,5 @@ CONFIG   += ordered
 
 SUBDIRS = libtiled tiled plugins \
     tmxviewer \
-    automappingconverter
+    automappingconverter \
+    automappingrunner
@@ -96,11 +96,7 @@ ObjectGroup *AbstractObjectTool::currentObjectGroup() const
 
 MapObjectItem *AbstractObjectTool::topMostObjectItemAt(QPointF pos) const
 {
-    foreach (QGraphicsItem *item, mMapScene->items(pos)) {
-        if (MapObjectItem *objectItem = dynamic_cast<MapObjectItem*>(item))
-            return objectItem;
-    }
-    return 0;
+    return mMapScene->objectItemsAt(pos).value(0);
 }
 
 /**
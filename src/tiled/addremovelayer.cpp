@@ -23,6 +23,7 @@
 #include "layer.h"
 #include "layermodel.h"
 #include "mapdocument.h"
+#include "tilelayer.h"
 
 namespace Tiled {
 namespace Internal {
@@ -41,16 +42,39 @@ AddRemoveLayer::~AddRemoveLayer()
     delete mLayer;
 }
 
+qint64 AddRemoveLayer::memoryUsage() const
+{
+    // Only a layer that isn't part of the map is owned by this command
+    if (!mLayer || !mLayer->isTileLayer())
+        return 0;
+
+    return mCells.memoryUsage(static_cast<const TileLayer*>(mLayer));
+}
+
+void AddRemoveLayer::compress()
+{
+    if (!mLayer)
+        return;
+
+    if (TileLayer *tileLayer = mLayer->asTileLayer())
+        mCells.compress(tileLayer);
+}
+
 void AddRemoveLayer::addLayer()
 {
     const int currentLayer = mMapDocument->currentLayerIndex();
 
+    if (TileLayer *tileLayer = mLayer->asTileLayer())
+        mCells.decompress(tileLayer);
+
     mMapDocument->layerModel()->insertLayer(mIndex, mLayer);
     mLayer = 0;
 
     // Insertion below or at the current layer increases current layer index
     if (mIndex <= currentLayer)
         mMapDocument->setCurrentLayerIndex(currentLayer + 1);
+
+    memoryUsageChanged();
 }
 
 void AddRemoveLayer::removeLayer()
@@ -62,6 +86,8 @@ void AddRemoveLayer::removeLayer()
     // Removal below the current layer decreases the current layer index
     if (mIndex < currentLayer)
         mMapDocument->setCurrentLayerIndex(currentLayer - 1);
+
+    memoryUsageChanged();
 }
 
 } // namespace Internal
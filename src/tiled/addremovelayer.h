@@ -21,6 +21,9 @@
 #ifndef ADDREMOVELAYER_H
 #define ADDREMOVELAYER_H
 
+#include "compressedcells.h"
+#include "undobudget.h"
+
 #include <QCoreApplication>
 #include <QUndoCommand>
 
@@ -35,13 +38,16 @@ class MapDocument;
 /**
  * Abstract base class for AddLayer and RemoveLayer.
  */
-class AddRemoveLayer : public QUndoCommand
+class AddRemoveLayer : public QUndoCommand, public CompressibleCommand
 {
 public:
     AddRemoveLayer(MapDocument *mapDocument, int index, Layer *layer);
 
     ~AddRemoveLayer();
 
+    qint64 memoryUsage() const;
+    void compress();
+
 protected:
     void addLayer();
     void removeLayer();
@@ -50,6 +56,7 @@ private:
     MapDocument *mMapDocument;
     Layer *mLayer;
     int mIndex;
+    CompressedCells mCells;
 };
 
 /**
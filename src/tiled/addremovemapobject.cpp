@@ -26,6 +26,8 @@
 #include "mapobjectmodel.h"
 
 #include <QCoreApplication>
+#include <QMap>
+#include <QSet>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -88,3 +90,109 @@ RemoveMapObject::RemoveMapObject(MapDocument *mapDocument,
 {
     setText(QCoreApplication::translate("Undo Commands", "Remove Object"));
 }
+
+
+AddRemoveMapObjects::AddRemoveMapObjects(MapDocument *mapDocument,
+                                         bool ownObjects,
+                                         QUndoCommand *parent)
+    : QUndoCommand(parent)
+    , mMapDocument(mapDocument)
+    , mOwnsObjects(ownObjects)
+{
+}
+
+AddRemoveMapObjects::~AddRemoveMapObjects()
+{
+    if (mOwnsObjects)
+        foreach (const GroupObjects &groupObjects, mGroups)
+            qDeleteAll(groupObjects.objects);
+}
+
+void AddRemoveMapObjects::addObjects()
+{
+    MapObjectModel *model = mMapDocument->mapObjectModel();
+    foreach (const GroupObjects &groupObjects, mGroups)
+        model->insertObjects(groupObjects.objectGroup,
+                             groupObjects.indexes,
+                             groupObjects.objects);
+    mOwnsObjects = false;
+}
+
+void AddRemoveMapObjects::removeObjects()
+{
+    MapObjectModel *model = mMapDocument->mapObjectModel();
+
+    for (int i = 0; i < mGroups.size(); ++i) {
+        GroupObjects &groupObjects = mGroups[i];
+        const QList<int> indexes = model->removeObjects(groupObjects.objectGroup,
+                                                        groupObjects.objects);
+
+        // Sort the objects by their index, so that they can be inserted
+        // again in ascending order. Objects that were not part of the group
+        // were not removed, so they are not inserted again either.
+        QMap<int, MapObject*> objectAtIndex;
+        for (int j = 0; j < indexes.size(); ++j) {
+            const int index = indexes.at(j);
+            if (index == -1)
+                continue;
+
+            Q_ASSERT(!objectAtIndex.contains(index));
+            objectAtIndex.insert(index, groupObjects.objects.at(j));
+        }
+
+        groupObjects.indexes = objectAtIndex.keys();
+        groupObjects.objects = objectAtIndex.values();
+    }
+
+    mOwnsObjects = true;
+}
+
+
+AddMapObjects::AddMapObjects(MapDocument *mapDocument,
+                             ObjectGroup *objectGroup,
+                             const QList<MapObject*> &mapObjects,
+                             QUndoCommand *parent)
+    : AddRemoveMapObjects(mapDocument, true, parent)
+{
+    GroupObjects groupObjects;
+    groupObjects.objectGroup = objectGroup;
+    groupObjects.objects = mapObjects;
+    for (int i = 0; i < mapObjects.size(); ++i)
+        groupObjects.indexes.append(-1);
+    mGroups.append(groupObjects);
+
+    setText(QCoreApplication::translate("Undo Commands", "Add Objects"));
+}
+
+
+RemoveMapObjects::RemoveMapObjects(MapDocument *mapDocument,
+                                   const QList<MapObject*> &mapObjects,
+                                   QUndoCommand *parent)
+    : AddRemoveMapObjects(mapDocument, false, parent)
+{
+    // Group the objects by their object group, removing each object once
+    QSet<MapObject*> seen;
+    foreach (MapObject *mapObject, mapObjects) {
+        if (seen.contains(mapObject))
+            continue;
+        seen.insert(mapObject);
+
+        ObjectGroup *objectGroup = mapObject->objectGroup();
+
+        int groupIndex = 0;
+        while (groupIndex < mGroups.size() &&
+               mGroups.at(groupIndex).objectGroup != objectGroup)
+            ++groupIndex;
+
+        if (groupIndex == mGroups.size()) {
+            GroupObjects groupObjects;
+            groupObjects.objectGroup = objectGroup;
+            mGroups.append(groupObjects);
+        }
+
+        mGroups[groupIndex].objects.append(mapObject);
+        mGroups[groupIndex].indexes.append(-1);
+    }
+
+    setText(QCoreApplication::translate("Undo Commands", "Remove Objects"));
+}
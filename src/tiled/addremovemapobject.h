@@ -21,6 +21,7 @@
 #ifndef ADDREMOVEMAPOBJECT_H
 #define ADDREMOVEMAPOBJECT_H
 
+#include <QList>
 #include <QUndoCommand>
 
 namespace Tiled {
@@ -89,6 +90,74 @@ public:
     { removeObject(); }
 };
 
+/**
+ * Abstract base class for AddMapObjects and RemoveMapObjects. Adds or removes
+ * a list of objects at once, so that the map object model and the scene are
+ * notified only once for each object group instead of once per object.
+ */
+class AddRemoveMapObjects : public QUndoCommand
+{
+public:
+    AddRemoveMapObjects(MapDocument *mapDocument,
+                        bool ownObjects,
+                        QUndoCommand *parent = 0);
+    ~AddRemoveMapObjects();
+
+protected:
+    void addObjects();
+    void removeObjects();
+
+    /**
+     * The objects of each object group, along with the index at which they
+     * should be inserted. Indexes are in ascending order, or -1 to append.
+     */
+    struct GroupObjects
+    {
+        ObjectGroup *objectGroup;
+        QList<MapObject*> objects;
+        QList<int> indexes;
+    };
+
+    MapDocument *mMapDocument;
+    QList<GroupObjects> mGroups;
+    bool mOwnsObjects;
+};
+
+/**
+ * Undo command that adds a list of objects to an object group.
+ */
+class AddMapObjects : public AddRemoveMapObjects
+{
+public:
+    AddMapObjects(MapDocument *mapDocument, ObjectGroup *objectGroup,
+                  const QList<MapObject*> &mapObjects,
+                  QUndoCommand *parent = 0);
+
+    void undo()
+    { removeObjects(); }
+
+    void redo()
+    { addObjects(); }
+};
+
+/**
+ * Undo command that removes a list of objects from the map. The objects may
+ * be part of different object groups.
+ */
+class RemoveMapObjects : public AddRemoveMapObjects
+{
+public:
+    RemoveMapObjects(MapDocument *mapDocument,
+                     const QList<MapObject*> &mapObjects,
+                     QUndoCommand *parent = 0);
+
+    void undo()
+    { addObjects(); }
+
+    void redo()
+    { removeObjects(); }
+};
+
 } // namespace Internal
 } // namespace Tiled
 
@@ -38,10 +38,25 @@
 #include "tilesetmanager.h"
 
 #include <QDebug>
+#if QT_VERSION >= 0x040800
+#include <QElapsedTimer>
+#endif
+#include <QFuture>
+#include <QThread>
+#include <QTime>
+#include <QtConcurrentRun>
+
+#include <algorithm>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+/**
+ * The minimum amount of positions a rule needs to be compared at before the
+ * work is spread over multiple threads.
+ */
+static const int minParallelArea = 64 * 64;
+
 /*
  * About the order of the methods in this file.
  * The Automapper class has 3 bigger public functions, that is
@@ -57,10 +72,16 @@ AutoMapper::AutoMapper(MapDocument *workingDocument, Map *rules,
     , mMapRules(rules)
     , mLayerInputRegions(0)
     , mLayerOutputRegions(0)
+    , mRuleChangeMargin(0)
     , mRulePath(rulePath)
     , mDeleteTiles(false)
     , mAutoMappingRadius(0)
     , mNoOverlappingRules(false)
+    , mOutputFeedsInput(false)
+    , mThreadCount(0)
+    , mRandomSeed(0)
+    , mProfiling(false)
+    , mProfile(0)
 {
     Q_ASSERT(mMapRules);
 
@@ -79,6 +100,13 @@ AutoMapper::~AutoMapper()
     cleanUpRulesMap();
 }
 
+void AutoMapper::setMapDocument(MapDocument *mapDocument)
+{
+    mMapDocument = mapDocument;
+    mMapWork = mapDocument ? mapDocument->map() : 0;
+    mTilesetReplacements.clear();
+}
+
 QSet<QString> AutoMapper::getTouchedTileLayers() const
 {
     return mTouchedTileLayers;
@@ -323,6 +351,24 @@ bool AutoMapper::setupRuleList()
         Q_ASSERT(coherentRegions(checkCoherent).length() == 1);
     }
 
+    // A rule is tried at every offset where its input overlaps the area (see
+    // ruleWindow()), and its output may lie beyond its input at that offset
+    mRuleChangeMargin = 0;
+    for (int i = 0; i < mRulesInput.size(); ++i) {
+        const QRect in = mRulesInput.at(i).boundingRect();
+        const QRect out = mRulesOutput.at(i).boundingRect();
+        if (in.isEmpty() || out.isEmpty())
+            continue;
+
+        const int left = in.right() - out.left();
+        const int top = in.bottom() - out.top();
+        const int right = in.right() - in.left() + out.right() - in.left();
+        const int bottom = in.bottom() - in.top() + out.bottom() - in.top();
+
+        mRuleChangeMargin = qMax(mRuleChangeMargin,
+                                 qMax(qMax(left, top), qMax(right, bottom)));
+    }
+
     return true;
 }
 
@@ -340,6 +386,9 @@ bool AutoMapper::prepareAutoMap()
     if (!setupTilesets(mMapRules, mMapWork))
         return false;
 
+    compileRules();
+    resolveSetLayers();
+
     return true;
 }
 
@@ -400,10 +449,11 @@ bool AutoMapper::setupCorrectIndexes()
 }
 
 // This cannot just be replaced by MapDocument::unifyTileset(Map),
-// because here mAddedTileset is modified.
+// because here mAddedTileset is modified and the rules map is left alone.
 bool AutoMapper::setupTilesets(Map *src, Map *dst)
 {
     QList<Tileset*> existingTilesets = dst->tilesets();
+    mTilesetReplacements.clear();
 
     // Add tilesets that are not yet part of dst map
     foreach (Tileset *tileset, src->tilesets()) {
@@ -431,11 +481,7 @@ bool AutoMapper::setupTilesets(Map *src, Map *dst)
                                                  replacementTile,
                                                  properties));
         }
-        src->replaceTileset(tileset, replacement);
-
-        TilesetManager *tilesetManager = TilesetManager::instance();
-        tilesetManager->addReference(replacement);
-        tilesetManager->removeReference(tileset);
+        mTilesetReplacements.insert(tileset, replacement);
     }
     return true;
 }
@@ -443,6 +489,11 @@ bool AutoMapper::setupTilesets(Map *src, Map *dst)
 void AutoMapper::autoMap(QRegion *where)
 {
     Q_ASSERT(mRulesInput.size() == mRulesOutput.size());
+    Q_ASSERT(mRulesInput.size() == mCompiledRules.size());
+
+    // Other automappers may have added layers since prepareAutoMap()
+    resolveSetLayers();
+
     // first resize the active area
     if (mAutoMappingRadius) {
         QRegion region;
@@ -457,13 +508,12 @@ void AutoMapper::autoMap(QRegion *where)
 
     // delete all the relevant area, if the property "DeleteTiles" is set
     if (mDeleteTiles) {
-        const QRegion setLayersRegion = getSetLayersRegion();
+        const QRegion region = getSetLayersRegion().toRegion(*where);
         for (int i = 0; i < mLayerList.size(); ++i) {
             RuleOutput *translationTable = mLayerList.at(i);
             foreach (Layer *layer, translationTable->keys()) {
                 const int index = mLayerList.at(i)->value(layer);
                 Layer *dstLayer = mMapWork->layerAt(index);
-                const QRegion region = setLayersRegion.intersected(*where);
                 TileLayer *dstTileLayer = dstLayer->asTileLayer();
                 if (dstTileLayer)
                     dstTileLayer->erase(region);
@@ -479,44 +529,96 @@ void AutoMapper::autoMap(QRegion *where)
     // This needs to be done, so you can rely on the order of the rules at all
     // locations
     QRegion ret;
-    foreach (const QRect &rect, where->rects())
-        for (int i = 0; i < mRulesInput.size(); ++i) {
-            // at the moment the parallel execution does not work yet
-            // TODO: make multithreading available!
-            // either by dividing the rules or the region to multiple threads
-            ret = ret.united(applyRule(i, rect));
+    foreach (const QRect &rect, where->rects()) {
+        if (mProfiling) {
+            ret = ret.united(profileRules(rect));
+        } else if (mOutputFeedsInput) {
+            // Whether a rule matches may depend on where it was applied
+            // before, so look for the matches while applying the rules.
+            for (int i = 0; i < mRulesInput.size(); ++i)
+                ret = ret.united(applyRule(i, rect));
+        } else {
+            const QVector<QVector<QPoint> > matches = findMatches(rect);
+            for (int i = 0; i < mRulesInput.size(); ++i)
+                ret = ret.united(applyMatches(i, matches.at(i)));
         }
+    }
+    addCopiedObjects();
+
     *where = where->united(ret);
 }
 
-const QRegion AutoMapper::getSetLayersRegion()
+OccupancyBitmap AutoMapper::getSetLayersRegion()
 {
-    QRegion result;
+    OccupancyBitmap result;
     foreach (const QString &name, mInputRules.names) {
         const int index = mMapWork->indexOfLayer(name, Layer::TileLayerType);
         if (index == -1)
             continue;
         TileLayer *setLayer = mMapWork->layerAt(index)->asTileLayer();
-        result |= setLayer->region();
+        result.add(setLayer->occupancy());
     }
     return result;
 }
 
-static bool compareLayerTo(const TileLayer *setLayer,
-                           const QVector<TileLayer*> &listYes,
-                           const QVector<TileLayer*> &listNo,
-                           const QRegion &ruleRegion, const QPoint &offset);
+/**
+ * Returns the given \a cell of the rules map, with its tile replaced by the
+ * one used in the working map according to the given tileset \a replacements.
+ */
+static inline Cell workingCell(const Cell &cell,
+                               const QHash<Tileset*, Tileset*> &replacements)
+{
+    if (cell.isEmpty() || replacements.isEmpty())
+        return cell;
+
+    Tileset *replacement = replacements.value(cell.tile->tileset());
+    if (!replacement)
+        return cell;
 
-QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
+    Cell result = cell;
+    result.tile = replacement->tileAt(cell.tile->id());
+    return result;
+}
+
+/**
+ * Returns the key used to compare cells within the compiled rules. The tile
+ * address is shifted to make room for the flags.
+ */
+static inline quint64 cellKey(const Cell &cell)
 {
-    QRect ret;
+    return (quint64(quintptr(cell.tile)) << 3)
+            | (quint64(cell.flippedHorizontally) << 2)
+            | (quint64(cell.flippedVertically) << 1)
+            | (quint64(cell.flippedAntiDiagonally) << 0);
+}
 
-    if (mLayerList.isEmpty())
-        return ret;
+static inline bool containsKey(const quint64 *keys, int begin, int end,
+                               quint64 key)
+{
+    for (int i = begin; i < end; ++i)
+        if (keys[i] == key)
+            return true;
+    return false;
+}
+
+void AutoMapper::setProfiling(bool enabled)
+{
+    mProfiling = enabled;
+    mRuleProfiles.clear();
+
+    if (!enabled)
+        return;
+
+    mRuleProfiles.resize(mRulesInput.size());
+    for (int i = 0; i < mRulesInput.size(); ++i) {
+        mRuleProfiles[i].bounds = mRulesInput.at(i).boundingRect()
+                .united(mRulesOutput.at(i).boundingRect());
+    }
+}
 
-    const QRegion ruleInput = mRulesInput.at(ruleIndex);
-    const QRegion ruleOutput = mRulesOutput.at(ruleIndex);
-    QRect rbr = ruleInput.boundingRect();
+QRect AutoMapper::ruleWindow(int ruleIndex, const QRect &where) const
+{
+    const QRect rbr = mCompiledRules.at(ruleIndex).inputBounds;
 
     // Since the rule itself is translated, we need to adjust the borders of the
     // loops. Decrease the size at all sides by one: There must be at least one
@@ -527,111 +629,551 @@ QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
     const int maxX = where.right() - rbr.left() + rbr.width() - 1;
     const int maxY = where.bottom() - rbr.top() + rbr.height() - 1;
 
+    return QRect(QPoint(minX, minY), QPoint(maxX, maxY));
+}
+
+QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
+{
+    QRect ret;
+
+    if (mLayerList.isEmpty())
+        return ret;
+
+    const CompiledRule &rule = mCompiledRules.at(ruleIndex);
+    const QRect rbr = rule.inputBounds;
+    const QRect window = ruleWindow(ruleIndex, where);
+
     // In this list of regions it is stored which parts or the map have already
     // been altered by exactly this rule. We store all the altered parts to
     // make sure there are no overlaps of the same rule applied to
     // (neighbouring) places
-    QList<QRegion> appliedRegions;
+    QVector<OccupancyBitmap> appliedRegions;
     if (mNoOverlappingRules)
-        for (int i = 0; i < mMapWork->layerCount(); i++)
-            appliedRegions.append(QRegion());
+        appliedRegions.resize(mMapWork->layerCount());
 
-    for (int y = minY; y <= maxY; ++y)
-    for (int x = minX; x <= maxX; ++x) {
-        bool anymatch = false;
-        foreach (const QString &index, mInputRules.indexes) {
-            const InputIndex &ii = mInputRules[index];
+    for (int y = window.top(); y <= window.bottom(); ++y) {
+        for (int x = window.left(); x <= window.right(); ++x) {
+            const QPoint pos(x, y);
+            if (!matchesRule(rule, pos))
+                continue;
 
-            bool allLayerNamesMatch = true;
-            foreach (const QString &name, ii.names) {
-                const int i = mMapWork->indexOfLayer(name, Layer::TileLayerType);
-                if (i == -1) {
-                    allLayerNamesMatch = false;
-                } else {
-                    const TileLayer *setLayer = mMapWork->layerAt(i)->asTileLayer();
-                    allLayerNamesMatch &= compareLayerTo(setLayer,
-                                                         ii[name].listYes,
-                                                         ii[name].listNo,
-                                                         ruleInput,
-                                                         QPoint(x, y));
-                }
-            }
-            if (allLayerNamesMatch) {
-                anymatch = true;
-                break;
-            }
+            if (mProfile)
+                ++mProfile->matches;
+
+            if (applyRuleAt(ruleIndex, pos, appliedRegions))
+                ret = ret.united(rbr.translated(pos));
         }
+    }
 
-        if (anymatch) {
-            int r = 0;
-            // choose by chance which group of rule_layers should be used:
-            if (mLayerList.size() > 1)
-                r = qrand() % mLayerList.size();
+    if (mProfile)
+        mProfile->candidates += qint64(window.width()) * window.height();
 
-            if (!mNoOverlappingRules) {
-                copyMapRegion(ruleOutput, QPoint(x, y), mLayerList.at(r));
-                ret = ret.united(rbr.translated(QPoint(x, y)));
-                continue;
-            }
+    return ret;
+}
 
-            bool missmatch = false;
-            RuleOutput *translationTable = mLayerList.at(r);
-            QList<Layer*> layers = translationTable->keys();
+QRect AutoMapper::profileRules(const QRect &where)
+{
+    QRect ret;
 
-            // check if there are no overlaps within this rule.
-            QVector<QRegion> ruleRegionInLayer;
-            for (int i = 0; i < layers.size(); ++i) {
-                Layer *layer = layers.at(i);
+    for (int i = 0; i < mRulesInput.size(); ++i) {
+        mProfile = &mRuleProfiles[i];
+
+#if QT_VERSION >= 0x040800
+        QElapsedTimer timer;
+#else
+        QTime timer;
+#endif
+        timer.start();
+
+        if (mOutputFeedsInput) {
+            ret = ret.united(applyRule(i, where));
+        } else {
+            const QVector<QVector<QPoint> > matches =
+                    findMatches(where, i, &mProfile->candidates);
+            mProfile->matches += matches.at(i).size();
+            ret = ret.united(applyMatches(i, matches.at(i)));
+        }
 
-                QRegion appliedPlace;
-                TileLayer *tileLayer = layer->asTileLayer();
-                if (tileLayer)
-                    appliedPlace = tileLayer->region();
-                else
-                    appliedPlace = tileRegionOfObjectGroup(layer->asObjectGroup());
+#if QT_VERSION >= 0x040800
+        mProfile->elapsed += timer.nsecsElapsed() / 1000;
+#else
+        mProfile->elapsed += qint64(timer.elapsed()) * 1000;
+#endif
+        mProfile = 0;
+    }
 
-                ruleRegionInLayer.append(appliedPlace.intersected(ruleOutput));
-                if (appliedRegions.at(i).intersects(
-                            ruleRegionInLayer[i].translated(x, y))) {
-                    missmatch = true;
-                    break;
-                }
+    return ret;
+}
+
+static bool scanOrderLessThan(const QPoint &a, const QPoint &b)
+{
+    return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+}
+
+QVector<QVector<QPoint> > AutoMapper::findMatches(const QRect &where,
+                                                 int onlyRule,
+                                                 qint64 *candidates) const
+{
+    const int threadCount = mThreadCount > 0 ? mThreadCount
+                                             : QThread::idealThreadCount();
+    const int area = where.width() * where.height();
+
+    QVector<QVector<QPoint> > matches;
+
+    if (onlyRule != -1 || threadCount <= 1 || area < minParallelArea) {
+        matches = findMatchesInBand(where, 0, 1, onlyRule, candidates);
+    } else {
+        // Spread the work over multiple threads
+        const int bandCount = qMin(where.height(), threadCount * 4);
+        QList<QFuture<QVector<QVector<QPoint> > > > bands;
+
+        for (int i = 0; i < bandCount; ++i)
+            bands.append(QtConcurrent::run(this,
+                                           &AutoMapper::findMatchesInBand,
+                                           where, i, bandCount,
+                                           -1, (qint64 *) 0));
+
+        matches.resize(mCompiledRules.size());
+        for (int i = 0; i < bands.size(); ++i) {
+            const QVector<QVector<QPoint> > bandMatches = bands.at(i).result();
+            for (int rule = 0; rule < bandMatches.size(); ++rule)
+                matches[rule] += bandMatches.at(rule);
+        }
+    }
+
+    // Matches may be found through multiple anchors or in a different order
+    // than by applyRule(), so put them in scan order.
+    for (int rule = 0; rule < matches.size(); ++rule) {
+        QVector<QPoint> &ruleMatches = matches[rule];
+        qSort(ruleMatches.begin(), ruleMatches.end(), scanOrderLessThan);
+        ruleMatches.erase(std::unique(ruleMatches.begin(), ruleMatches.end()),
+                          ruleMatches.end());
+    }
+
+    return matches;
+}
+
+/**
+ * Returns the rows of \a area that belong to the given \a band.
+ */
+static QRect bandRect(const QRect &area, int band, int bandCount)
+{
+    const int top = area.top() + area.height() * band / bandCount;
+    const int bottom = area.top() + area.height() * (band + 1) / bandCount - 1;
+    return QRect(QPoint(area.left(), top), QPoint(area.right(), bottom));
+}
+
+QVector<QVector<QPoint> > AutoMapper::findMatchesInBand(const QRect &where,
+                                                       int band,
+                                                       int bandCount,
+                                                       int onlyRule,
+                                                       qint64 *candidates) const
+{
+    QVector<QVector<QPoint> > matches(mCompiledRules.size());
+
+    QVector<QRect> windows(mCompiledRules.size());
+    for (int i = 0; i < mCompiledRules.size(); ++i)
+        windows[i] = ruleWindow(i, where);
+
+    // Rules without anchor need to be compared at every position
+    foreach (const int ruleIndex, mUnanchoredRules) {
+        if (onlyRule != -1 && ruleIndex != onlyRule)
+            continue;
+
+        const CompiledRule &rule = mCompiledRules.at(ruleIndex);
+        const QRect window = bandRect(windows.at(ruleIndex), band, bandCount);
+        if (candidates)
+            *candidates += qint64(window.width()) * window.height();
+
+        for (int y = window.top(); y <= window.bottom(); ++y) {
+            for (int x = window.left(); x <= window.right(); ++x) {
+                const QPoint pos(x, y);
+                if (matchesRule(rule, pos))
+                    matches[ruleIndex].append(pos);
             }
-            if (missmatch)
-                continue;
+        }
+    }
+
+    // Other rules are only compared where the map has one of their anchors.
+    // The anchor of a rule can be anywhere within its input, so the cells to
+    // scan are the rule window widened by the input bounds.
+    QRect scanArea;
+    for (int i = 0; i < mCompiledRules.size(); ++i) {
+        const QRect &window = windows.at(i);
+        const QRect &rbr = mCompiledRules.at(i).inputBounds;
+        scanArea |= QRect(window.topLeft() + rbr.topLeft(),
+                          window.bottomRight() + rbr.bottomRight());
+    }
+
+    for (int i = 0; i < mAnchors.size(); ++i) {
+        const QHash<quint64, QVector<RuleAnchor> > &anchors = mAnchors.at(i);
+        const TileLayer *setLayer = mSetLayers.at(i);
+        if (anchors.isEmpty() || !setLayer)
+            continue;
+
+        const QRect layerArea = scanArea.intersected(
+                    QRect(0, 0, setLayer->width(), setLayer->height()));
+        const QRect area = bandRect(layerArea, band, bandCount);
+
+        for (int y = area.top(); y <= area.bottom(); ++y) {
+            for (int x = area.left(); x <= area.right(); ++x) {
+                const Cell &cell = setLayer->cellAt(x, y);
+                if (cell.isEmpty())
+                    continue;
+
+                QHash<quint64, QVector<RuleAnchor> >::const_iterator it =
+                        anchors.find(cellKey(cell));
+                if (it == anchors.constEnd())
+                    continue;
 
-            copyMapRegion(ruleOutput, QPoint(x, y), mLayerList.at(r));
-            ret = ret.united(rbr.translated(QPoint(x, y)));
-            for (int i = 0; i < translationTable->size(); ++i) {
-                appliedRegions[i] +=
-                        ruleRegionInLayer[i].translated(x, y);
+                foreach (const RuleAnchor &anchor, it.value()) {
+                    if (onlyRule != -1 && anchor.rule != onlyRule)
+                        continue;
+
+                    const QPoint pos(x - anchor.pos.x(), y - anchor.pos.y());
+                    if (!windows.at(anchor.rule).contains(pos))
+                        continue;
+
+                    if (candidates)
+                        ++*candidates;
+
+                    if (matchesRule(mCompiledRules.at(anchor.rule), pos))
+                        matches[anchor.rule].append(pos);
+                }
             }
         }
     }
 
+    return matches;
+}
+
+QRect AutoMapper::applyMatches(int ruleIndex, const QVector<QPoint> &matches)
+{
+    QRect ret;
+
+    if (mLayerList.isEmpty())
+        return ret;
+
+    const QRect rbr = mCompiledRules.at(ruleIndex).inputBounds;
+
+    // See applyRule()
+    QVector<OccupancyBitmap> appliedRegions;
+    if (mNoOverlappingRules)
+        appliedRegions.resize(mMapWork->layerCount());
+
+    foreach (const QPoint &pos, matches)
+        if (applyRuleAt(ruleIndex, pos, appliedRegions))
+            ret = ret.united(rbr.translated(pos));
+
     return ret;
 }
 
+bool AutoMapper::applyRuleAt(int ruleIndex, const QPoint &pos,
+                             QVector<OccupancyBitmap> &appliedRegions)
+{
+    const QRegion &ruleOutput = mRulesOutput.at(ruleIndex);
+
+    // choose by chance which group of rule_layers should be used:
+    RuleOutput *translationTable = mLayerList.at(chooseOutput(ruleIndex, pos));
+
+    if (!mNoOverlappingRules) {
+        copyMapRegion(ruleOutput, pos, translationTable);
+        if (mProfile)
+            ++mProfile->applied;
+        return true;
+    }
+
+    QList<Layer*> layers = translationTable->keys();
+
+    // check if there are no overlaps within this rule.
+    QVector<const QVector<QRect> *> ruleRectsInLayer;
+    for (int i = 0; i < layers.size(); ++i) {
+        const QVector<QRect> &rects = ruleOutputRects(ruleIndex, layers.at(i));
+        ruleRectsInLayer.append(&rects);
+
+        foreach (const QRect &rect, rects)
+            if (appliedRegions.at(i).intersects(rect.translated(pos)))
+                return false;
+    }
+
+    copyMapRegion(ruleOutput, pos, translationTable);
+    for (int i = 0; i < ruleRectsInLayer.size(); ++i)
+        foreach (const QRect &rect, *ruleRectsInLayer.at(i))
+            appliedRegions[i].add(rect.translated(pos));
+
+    if (mProfile)
+        ++mProfile->applied;
+
+    return true;
+}
+
+const QVector<QRect> &AutoMapper::ruleOutputRects(int ruleIndex, Layer *layer)
+{
+    const QPair<int, Layer*> key(ruleIndex, layer);
+
+    QHash<QPair<int, Layer*>, QVector<QRect> >::iterator it =
+            mRuleOutputRects.find(key);
+    if (it != mRuleOutputRects.end())
+        return it.value();
+
+    const QRegion region =
+            outputLayerRegion(layer).intersected(mRulesOutput.at(ruleIndex));
+    return mRuleOutputRects.insert(key, region.rects()).value();
+}
+
+const QRegion &AutoMapper::outputLayerRegion(Layer *layer)
+{
+    QHash<Layer*, QRegion>::iterator it = mOutputLayerRegions.find(layer);
+    if (it != mOutputLayerRegions.end())
+        return it.value();
+
+    QRegion region;
+    if (TileLayer *tileLayer = layer->asTileLayer())
+        region = tileLayer->region();
+    else if (ObjectGroup *objectGroup = layer->asObjectGroup())
+        region = tileRegionOfObjectGroup(objectGroup);
+
+    return mOutputLayerRegions.insert(layer, region).value();
+}
+
+/**
+ * The finalizer of MurmurHash3, used to scramble the bits of a hash.
+ */
+static inline quint32 mixBits(quint32 h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+int AutoMapper::chooseOutput(int ruleIndex, const QPoint &pos) const
+{
+    if (mLayerList.size() < 2)
+        return 0;
+
+    quint32 h = mixBits(mRandomSeed ^ quint32(ruleIndex));
+    h = mixBits(h ^ quint32(pos.x()));
+    h = mixBits(h ^ quint32(pos.y()));
+    return h % mLayerList.size();
+}
+
 /**
- * Returns a list of all cells which can be found within all tile layers
- * within the given region.
+ * Appends the non-empty cells found at \a x, \a y in the given \a layers to
+ * the keys of \a condition, skipping duplicates after \a begin. Marks the
+ * condition as unmatchable when the position is outside of any layer. The
+ * keys refer to the tiles of the working map, see workingCell().
+ *
+ * Returns whether any cell was found.
  */
-static QVector<Cell> cellsInRegion(const QVector<TileLayer*> &list,
-                                   const QRegion &r)
+static bool appendCellKeys(RuleInputCondition &condition,
+                           const QVector<TileLayer*> &layers,
+                           int x, int y, int begin,
+                           const QHash<Tileset*, Tileset*> &replacements)
+{
+    bool found = false;
+    foreach (const TileLayer *layer, layers) {
+        if (!layer->contains(x, y)) {
+            condition.matchable = false;
+            continue;
+        }
+
+        const Cell &cell = layer->cellAt(x, y);
+        if (cell.isEmpty())
+            continue;
+
+        found = true;
+        const quint64 key = cellKey(workingCell(cell, replacements));
+        if (!containsKey(condition.keys.constData(), begin,
+                         condition.keys.size(), key))
+            condition.keys.append(key);
+    }
+    return found;
+}
+
+static RuleInputCondition compileCondition(const QVector<TileLayer*> &listYes,
+                                           const QVector<TileLayer*> &listNo,
+                                           const QRegion &ruleRegion,
+                                           const QHash<Tileset*, Tileset*> &replacements)
 {
-    QVector<Cell> cells;
-    foreach (const TileLayer *tilelayer, list) {
-        foreach (const QRect &rect, r.rects()) {
+    RuleInputCondition condition;
+    condition.hasYes = !listYes.isEmpty();
+    condition.hasNo = !listNo.isEmpty();
+
+    // A rule without any layers is considered erroneous
+    if (!condition.hasYes && !condition.hasNo) {
+        condition.matchable = false;
+        return condition;
+    }
+
+    foreach (const QRect &rect, ruleRegion.rects()) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
             for (int x = rect.left(); x <= rect.right(); ++x) {
-                for (int y = rect.top(); y <= rect.bottom(); ++y) {
-                    const Cell &cell = tilelayer->cellAt(x, y);
-                    if (!cells.contains(cell))
-                        cells.append(cell);
+                RuleInputPosition position;
+                position.x = x;
+                position.y = y;
+
+                position.allowedBegin = condition.keys.size();
+                position.yesDefined = appendCellKeys(condition, listYes, x, y,
+                                                     position.allowedBegin,
+                                                     replacements);
+                position.allowedEnd = condition.keys.size();
+
+                position.forbiddenBegin = condition.keys.size();
+                appendCellKeys(condition, listNo, x, y,
+                               position.forbiddenBegin, replacements);
+                position.forbiddenEnd = condition.keys.size();
+
+                condition.positions.append(position);
+
+                if (!condition.hasNo) {
+                    const int begin = position.allowedBegin;
+                    const int end = position.allowedEnd;
+                    for (int i = begin; i < end; ++i)
+                        condition.usedCells.insert(condition.keys.at(i));
                 }
             }
         }
     }
-    return cells;
+
+    return condition;
+}
+
+void AutoMapper::compileRules()
+{
+    mCompiledRules.clear();
+    mSetLayerNames.clear();
+    mCompiledRules.reserve(mRulesInput.size());
+
+    // Assign each input layer name an index into the resolved set layers
+    QMap<QString, int> setLayerIndexes;
+    foreach (const QString &name, mInputRules.names) {
+        setLayerIndexes.insert(name, mSetLayerNames.size());
+        mSetLayerNames.append(name);
+    }
+
+    foreach (const QRegion &ruleInput, mRulesInput) {
+        CompiledRule rule;
+        rule.inputBounds = ruleInput.boundingRect();
+
+        foreach (const QString &index, mInputRules.indexes) {
+            const InputIndex &inputIndex = mInputRules[index];
+
+            QVector<RuleInputCondition> conditions;
+            foreach (const QString &name, inputIndex.names) {
+                const InputIndexName &lists = inputIndex[name];
+                RuleInputCondition condition = compileCondition(lists.listYes,
+                                                                lists.listNo,
+                                                                ruleInput,
+                                                                mTilesetReplacements);
+                condition.setLayer = setLayerIndexes.value(name);
+                conditions.append(condition);
+            }
+            rule.alternatives.append(conditions);
+        }
+
+        mCompiledRules.append(rule);
+    }
+
+    buildAnchorIndex();
+}
+
+void AutoMapper::buildAnchorIndex()
+{
+    mAnchors.clear();
+    mAnchors.resize(mSetLayerNames.size());
+    mUnanchoredRules.clear();
+
+    for (int ruleIndex = 0; ruleIndex < mCompiledRules.size(); ++ruleIndex) {
+        const CompiledRule &rule = mCompiledRules.at(ruleIndex);
+
+        // Each alternative that can match needs an anchor, which is the
+        // required position that allows the least amount of cells. These are
+        // stored as pairs of condition and position indexes.
+        QVector<QPair<const RuleInputCondition*, int> > ruleAnchors;
+        bool anchored = true;
+
+        for (int a = 0; a < rule.alternatives.size() && anchored; ++a) {
+            const QVector<RuleInputCondition> &conditions =
+                    rule.alternatives.at(a);
+
+            const RuleInputCondition *bestCondition = 0;
+            int bestPosition = -1;
+            int bestCount = 0;
+            bool matchable = true;
+
+            for (int c = 0; c < conditions.size(); ++c) {
+                const RuleInputCondition &condition = conditions.at(c);
+                if (!condition.matchable)
+                    matchable = false;
+
+                for (int p = 0; p < condition.positions.size(); ++p) {
+                    const RuleInputPosition &position = condition.positions.at(p);
+                    if (!position.yesDefined)
+                        continue;
+
+                    const int count = position.allowedEnd - position.allowedBegin;
+                    if (!bestCondition || count < bestCount) {
+                        bestCondition = &condition;
+                        bestPosition = p;
+                        bestCount = count;
+                    }
+                }
+            }
+
+            // Alternatives that can never match do not need an anchor
+            if (!matchable)
+                continue;
+
+            if (bestCondition)
+                ruleAnchors.append(qMakePair(bestCondition, bestPosition));
+            else
+                anchored = false;
+        }
+
+        if (!anchored) {
+            mUnanchoredRules.append(ruleIndex);
+            continue;
+        }
+
+        for (int i = 0; i < ruleAnchors.size(); ++i) {
+            const RuleInputCondition *condition = ruleAnchors.at(i).first;
+            const RuleInputPosition &position =
+                    condition->positions.at(ruleAnchors.at(i).second);
+
+            RuleAnchor anchor;
+            anchor.rule = ruleIndex;
+            anchor.pos = QPoint(position.x, position.y);
+
+            QHash<quint64, QVector<RuleAnchor> > &anchors =
+                    mAnchors[condition->setLayer];
+            for (int k = position.allowedBegin; k < position.allowedEnd; ++k)
+                anchors[condition->keys.at(k)].append(anchor);
+        }
+    }
+}
+
+void AutoMapper::resolveSetLayers()
+{
+    mSetLayers.fill(0, mSetLayerNames.size());
+
+    for (int i = 0; i < mSetLayerNames.size(); ++i) {
+        const int index = mMapWork->indexOfLayer(mSetLayerNames.at(i),
+                                                 Layer::TileLayerType);
+        if (index != -1)
+            mSetLayers[i] = mMapWork->layerAt(index)->asTileLayer();
+    }
+
+    mOutputFeedsInput = false;
+    foreach (const RuleOutput *translationTable, mLayerList) {
+        foreach (const int index, translationTable->values()) {
+            TileLayer *tileLayer = mMapWork->layerAt(index)->asTileLayer();
+            if (tileLayer && mSetLayers.contains(tileLayer))
+                mOutputFeedsInput = true;
+        }
+    }
 }
 
 /**
@@ -647,6 +1189,8 @@ static QVector<Cell> cellsInRegion(const QVector<TileLayer*> &list,
  * in the QList listYes (ruleSet) and OList listNo (ruleNotSet).
  * The tile layer setLayer is examined at QRegion ruleRegion + offset
  * The tile layers within listYes and listNo are examined at QRegion ruleRegion.
+ * Both lists have been compiled into the allowed and forbidden cells of each
+ * position of the \a condition beforehand, see compileCondition().
  *
  * Basically all matches between setLayer and a layer of listYes are considered
  * good, while all matches between setLayer and listNo are considered bad and
@@ -700,99 +1244,79 @@ static QVector<Cell> cellsInRegion(const QVector<TileLayer*> &list,
  *
  * @return bool, if the tile layer matches the given list of layers.
  */
-static bool compareLayerTo(const TileLayer *setLayer,
-                           const QVector<TileLayer*> &listYes,
-                           const QVector<TileLayer*> &listNo,
-                           const QRegion &ruleRegion, const QPoint &offset)
+static bool matchesCondition(const RuleInputCondition &condition,
+                             const TileLayer *setLayer,
+                             const QPoint &offset)
 {
-    if (listYes.isEmpty() && listNo.isEmpty())
+    if (!condition.matchable || !setLayer)
         return false;
 
-    QVector<Cell> cells;
-    if (listYes.isEmpty())
-        cells = cellsInRegion(listNo, ruleRegion);
-    if (listNo.isEmpty())
-        cells = cellsInRegion(listYes, ruleRegion);
-
-    foreach (const QRect &rect, ruleRegion.rects()) {
-        for (int x = rect.left(); x <= rect.right(); ++x) {
-            for (int y = rect.top(); y <= rect.bottom(); ++y) {
-                // this is only used in the case where only one list has layers
-                // it is needed for the exception mentioned above
-                bool ruleDefinedListYes = false;
-
-                bool matchListYes = false;
-                bool matchListNo  = false;
-
-                if (!setLayer->contains(x + offset.x(), y + offset.y()))
-                    return false;
+    const quint64 *keys = condition.keys.constData();
+    const RuleInputPosition *positions = condition.positions.constData();
+    const int count = condition.positions.size();
 
-                const Cell &c1 = setLayer->cellAt(x + offset.x(),
-                                                  y + offset.y());
+    for (int i = 0; i < count; ++i) {
+        const RuleInputPosition &p = positions[i];
+        const int x = p.x + offset.x();
+        const int y = p.y + offset.y();
 
-                // when there is no tile in setLayer,
-                // there should be no rule at all
-                if (c1.isEmpty())
-                    return false;
+        if (!setLayer->contains(x, y))
+            return false;
 
-                // ruleDefined will be set when there is a tile in at least
-                // one layer. if there is a tile in at least one layer, only
-                // the given tiles in the different listYes layers are valid.
-                // if there is given no tile at all in the listYes layers,
-                // consider all tiles valid.
+        // when there is no tile in setLayer,
+        // there should be no rule at all
+        const Cell &cell = setLayer->cellAt(x, y);
+        if (cell.isEmpty())
+            return false;
 
-                foreach (const TileLayer *comparedTileLayer, listYes) {
+        const quint64 key = cellKey(cell);
 
-                    if (!comparedTileLayer->contains(x, y))
-                        return false;
+        if (containsKey(keys, p.forbiddenBegin, p.forbiddenEnd, key))
+            return false;
 
-                    const Cell &c2 = comparedTileLayer->cellAt(x, y);
-                    if (!c2.isEmpty())
-                        ruleDefinedListYes = true;
-
-                    if (!c2.isEmpty() && c1 == c2)
-                        matchListYes = true;
-                }
-                foreach (const TileLayer *comparedTileLayer, listNo) {
+        // when there are only layers in the listNo, we are done
+        if (!condition.hasYes)
+            continue;
 
-                    if (!comparedTileLayer->contains(x, y))
-                        return false;
+        if (containsKey(keys, p.allowedBegin, p.allowedEnd, key))
+            continue;
 
-                    const Cell &c2 = comparedTileLayer->cellAt(x, y);
+        if (p.yesDefined)
+            return false;
 
-                    if (!c2.isEmpty() && c1 == c2)
-                        matchListNo = true;
-                }
+        // there are layers in both lists, so any tile is fine here
+        if (condition.hasNo)
+            continue;
 
-                // when there are only layers in the listNo
-                // check only if these layers are unmatched
-                // no need to check explicitly the exception in this case.
-                if (listYes.isEmpty()) {
-                    if (matchListNo)
-                        return false;
-                    else
-                        continue;
-                }
-                // when there are only layers in the listYes
-                // check if these layers are matched, or if the exception works
-                if (listNo.isEmpty()) {
-                    if (matchListYes)
-                        continue;
-                    if (!ruleDefinedListYes && !cells.contains(c1))
-                        continue;
-                    return false;
-                }
+        // only layers in the listYes: the exception applies
+        if (condition.usedCells.contains(key))
+            return false;
+    }
+    return true;
+}
 
-                // there are layers in both lists:
-                // no need to consider ruleDefinedListXXX
-                if ((matchListYes || !ruleDefinedListYes) && !matchListNo)
-                    continue;
-                else
-                    return false;
+bool AutoMapper::matchesRule(const CompiledRule &rule,
+                             const QPoint &offset) const
+{
+    const QVector<QVector<RuleInputCondition> > &alternatives =
+            rule.alternatives;
+
+    for (int i = 0; i < alternatives.size(); ++i) {
+        const QVector<RuleInputCondition> &conditions = alternatives.at(i);
+
+        bool allLayerNamesMatch = true;
+        for (int j = 0; j < conditions.size(); ++j) {
+            const RuleInputCondition &condition = conditions.at(j);
+            if (!matchesCondition(condition, mSetLayers.at(condition.setLayer),
+                                  offset)) {
+                allLayerNamesMatch = false;
+                break;
             }
         }
+        if (allLayerNamesMatch)
+            return true;
     }
-    return true;
+    return false;
 }
 
 void AutoMapper::copyMapRegion(const QRegion &region, QPoint offset,
@@ -843,7 +1367,9 @@ void AutoMapper::copyTileRegion(TileLayer *srcLayer, int srcX, int srcY,
             const Cell &cell = srcLayer->cellAt(x + offsetX, y + offsetY);
             if (!cell.isEmpty()) {
                 // this is without graphics update, it's done afterwards for all
-                dstLayer->setCell(x, y, cell);
+                dstLayer->setCell(x, y, workingCell(cell, mTilesetReplacements));
+                if (mProfile)
+                    ++mProfile->cellsWritten;
             }
         }
     }
@@ -853,20 +1379,39 @@ void AutoMapper::copyObjectRegion(ObjectGroup *srcLayer, int srcX, int srcY,
                                  int width, int height,
                                  ObjectGroup *dstLayer, int dstX, int dstY)
 {
-    QUndoStack *undo = mMapDocument->undoStack();
     const QRect rect = QRect(srcX, srcY, width, height);
     QList<MapObject*> objects = objectsInRegion(srcLayer, rect);
+    if (objects.isEmpty())
+        return;
+
+    if (mProfile)
+        mProfile->objectsWritten += objects.size();
 
-    QList<MapObject*> clones;
+    QList<MapObject*> &clones = mCopiedObjects[dstLayer];
     foreach (MapObject *obj, objects) {
         MapObject *clone = obj->clone();
-        clones.append(clone);
+        if (Tile *tile = clone->tile()) {
+            Tileset *replacement = mTilesetReplacements.value(tile->tileset());
+            if (replacement)
+                clone->setTile(replacement->tileAt(tile->id()));
+        }
         clone->setX(clone->x() + dstX - srcX);
         clone->setY(clone->y() + dstY - srcY);
-        undo->push(new AddMapObject(mMapDocument, dstLayer, clone));
+        clones.append(clone);
     }
 }
 
+void AutoMapper::addCopiedObjects()
+{
+    QUndoStack *undo = mMapDocument->undoStack();
+
+    QMap<ObjectGroup*, QList<MapObject*> >::const_iterator it;
+    for (it = mCopiedObjects.constBegin(); it != mCopiedObjects.constEnd(); ++it)
+        undo->push(new AddMapObjects(mMapDocument, it.key(), it.value()));
+
+    mCopiedObjects.clear();
+}
+
 void AutoMapper::cleanAll()
 {
     cleanTilesets();
@@ -924,6 +1469,9 @@ void AutoMapper::cleanUpRulesMap()
     cleanUpRuleMapLayers();
     mRulesInput.clear();
     mRulesOutput.clear();
+    mCompiledRules.clear();
+    mAnchors.clear();
+    mUnanchoredRules.clear();
 }
 
 void AutoMapper::cleanUpRuleMapLayers()
@@ -939,4 +1487,6 @@ void AutoMapper::cleanUpRuleMapLayers()
     mLayerInputRegions = 0;
     mLayerOutputRegions = 0;
     mInputRules.clear();
+    mOutputLayerRegions.clear();
+    mRuleOutputRects.clear();
 }
@@ -21,13 +21,21 @@
 #ifndef AUTOMAPPER_H
 #define AUTOMAPPER_H
 
+#include "occupancybitmap.h"
+
+#include <QHash>
 #include <QMap>
 #include <QList>
+#include <QPair>
+#include <QPoint>
 
 #include <QRegion>
 
+#include <QRect>
 #include <QSet>
+#include <QSize>
 #include <QString>
+#include <QStringList>
 #include <QVector>
 
 namespace Tiled {
@@ -69,6 +77,131 @@ public:
     QString index;
 };
 
+/**
+ * A single position of the input region of a rule, with the cells that are
+ * allowed and forbidden there. The cells are stored as ranges into the keys
+ * of the owning RuleInputCondition.
+ */
+class RuleInputPosition
+{
+public:
+    int x;
+    int y;
+    int allowedBegin;
+    int allowedEnd;
+    int forbiddenBegin;
+    int forbiddenEnd;
+    bool yesDefined;
+};
+
+/**
+ * The compiled form of the input and inputnot layers of one layer name,
+ * restricted to the input region of one rule.
+ */
+class RuleInputCondition
+{
+public:
+    RuleInputCondition()
+        : setLayer(-1)
+        , matchable(true)
+        , hasYes(false)
+        , hasNo(false)
+    {}
+
+    /**
+     * Index into the resolved set layers of the AutoMapper.
+     */
+    int setLayer;
+
+    /**
+     * False when the condition can never match, for example because the rule
+     * region reaches outside of one of the input layers.
+     */
+    bool matchable;
+
+    bool hasYes;
+    bool hasNo;
+
+    QVector<RuleInputPosition> positions;
+    QVector<quint64> keys;
+
+    /**
+     * All cells used within the input layers, needed for the "any tile
+     * except the used ones" fallback when there are only input layers.
+     */
+    QSet<quint64> usedCells;
+};
+
+/**
+ * A cell position of a rule at which only a small set of cells is allowed.
+ */
+class RuleAnchor
+{
+public:
+    int rule;
+    QPoint pos;
+};
+
+/**
+ * A rule compiled to a flat pattern, so that it can be compared to the
+ * working map without looking up layers or collecting cells.
+ *
+ * The rule matches when all conditions of any of the alternatives match.
+ * There is one alternative for each input index.
+ */
+class CompiledRule
+{
+public:
+    QRect inputBounds;
+    QVector<QVector<RuleInputCondition> > alternatives;
+};
+
+/**
+ * What happened while applying a single rule, collected when profiling is
+ * enabled on the AutoMapper.
+ */
+class RuleProfile
+{
+public:
+    RuleProfile()
+        : matches(0)
+        , candidates(0)
+        , applied(0)
+        , cellsWritten(0)
+        , objectsWritten(0)
+        , elapsed(0)
+    {}
+
+    /**
+     * The bounding rect of the rule within the rules map.
+     */
+    QRect bounds;
+
+    /**
+     * The number of positions at which the rule matched.
+     */
+    qint64 matches;
+
+    /**
+     * The number of positions at which the rule was compared to the map.
+     */
+    qint64 candidates;
+
+    /**
+     * The number of matches at which the output of the rule was applied,
+     * which may be less than the matches when rules may not overlap.
+     */
+    qint64 applied;
+
+    qint64 cellsWritten;
+    qint64 objectsWritten;
+
+    /**
+     * The time spent on matching and applying the rule, in microseconds.
+     */
+    qint64 elapsed;
+};
+
 
 /**
  * This class does all the work for the automapping feature.
@@ -96,6 +229,12 @@ public:
                const QString &rulePath);
     ~AutoMapper();
 
+    /**
+     * Sets the map document to work on, so that the same rules can be used
+     * for multiple maps. Needs to be followed by prepareAutoMap().
+     */
+    void setMapDocument(MapDocument *mapDocument);
+
     /**
      * Checks if the passed \a ruleLayerName is used in this instance 
      * of Automapper.
@@ -122,6 +261,12 @@ public:
      */
     void autoMap(QRegion *where);
 
+    /**
+     * Returns how many tiles outside of the region passed to autoMap() the
+     * map may be changed by this automapper.
+     */
+    int changeMargin() const { return mAutoMappingRadius + mRuleChangeMargin; }
+
     /**
      * This cleans all datastructures, which are setup via prepareAutoMap,
      * so the auto mapper becomes ready for its next automatic mapping.
@@ -141,6 +286,42 @@ public:
      */
     QString warningString() const { return mWarning; }
 
+    /**
+     * Sets the number of threads used for finding the places where the rules
+     * match. A value of 1 disables multithreading, while 0 (the default)
+     * uses the ideal thread count. The result does not depend on this.
+     */
+    void setThreadCount(int threadCount) { mThreadCount = threadCount; }
+    int threadCount() const { return mThreadCount; }
+
+    /**
+     * Sets the seed used for choosing between the alternative outputs of a
+     * rule. The choice only depends on this seed, the rule and the position
+     * where it is applied, so that automapping is reproducible. The
+     * AutomappingManager picks a new seed for each run.
+     */
+    void setRandomSeed(uint seed) { mRandomSeed = seed; }
+    uint randomSeed() const { return mRandomSeed; }
+
+    /**
+     * Enables collecting a profile of each rule during autoMap(). While
+     * profiling, the rules are matched one after the other on a single
+     * thread, so that the time spent can be attributed to each rule.
+     */
+    void setProfiling(bool enabled);
+    bool isProfiling() const { return mProfiling; }
+
+    /**
+     * Returns the profile of each rule, accumulated over all calls to
+     * autoMap() since profiling was enabled.
+     */
+    const QVector<RuleProfile> &ruleProfiles() const { return mRuleProfiles; }
+
+    /**
+     * Returns the file path of the rules map.
+     */
+    QString rulePath() const { return mRulePath; }
+
 private:
     /**
      * Reads the map properties of the rulesmap.
@@ -179,15 +360,43 @@ private:
 
     /**
      * sets up the tilesets which are used in automapping.
+     * The \a src map is not changed, since the rules map may be used for
+     * several map documents. Instead, tilesets of \a src that are replaced
+     * by a similar tileset of \a dst are stored in mTilesetReplacements.
      * @return returns true when anything is ok, false when errors occured.
      *        (in that case will be a msg box anyway)
      */
     bool setupTilesets(Map *src, Map *dst);
 
+    /**
+     * Compiles the input regions of all rules to a CompiledRule, which is
+     * stored in mCompiledRules. Needs to be done after setupTilesets(),
+     * since the rules refer to the tiles of the working map.
+     */
+    void compileRules();
+
+    /**
+     * Builds mAnchors from the compiled rules, by choosing the most selective
+     * required cell of each alternative of each rule.
+     */
+    void buildAnchorIndex();
+
+    /**
+     * Looks up the layers of the working map which the compiled rules are
+     * compared to.
+     */
+    void resolveSetLayers();
+
+    /**
+     * Returns whether the given compiled \a rule matches the working map
+     * when translated by \a offset.
+     */
+    bool matchesRule(const CompiledRule &rule, const QPoint &offset) const;
+
     /**
      * Returns the conjunction of of all regions of all setlayers
      */
-    const QRegion getSetLayersRegion();
+    OccupancyBitmap getSetLayersRegion();
 
     /**
      * This copies all Tiles from TileLayer src to TileLayer dst
@@ -211,11 +420,18 @@ private:
      * The rectangle is described by the upper left corner \a src_x \a src_y
      * and its \a width and \a height. The parameter \a dst_x and \a dst_y
      * offset the copied objects in the destination object group.
+     *
+     * The copies are only added to the destination by addCopiedObjects().
      */
     void copyObjectRegion(ObjectGroup *src_lr, int src_x, int src_y,
                           int width, int height, ObjectGroup *dst_lr,
                           int dst_x, int dst_y);
 
+    /**
+     * Adds the objects copied by copyObjectRegion() to their object groups,
+     * using a single undo command for each object group.
+     */
+    void addCopiedObjects();
 
     /**
      * This copies multiple TileLayers from one map to another.
@@ -237,6 +453,79 @@ private:
      */
     QRect applyRule(const int ruleIndex, const QRect &where);
 
+    /**
+     * Returns the range of positions at which the rule needs to be compared
+     * to the working map, to find the matches overlapping \a where.
+     */
+    QRect ruleWindow(int ruleIndex, const QRect &where) const;
+
+    /**
+     * Finds the positions where each rule matches near \a where, without
+     * applying any of them. Only valid when the output of the rules does not
+     * feed their input. The positions of each rule are in scan order.
+     *
+     * When \a onlyRule is given, only that rule is looked for on the calling
+     * thread, and the number of positions it was compared at is added to
+     * \a candidates.
+     */
+    QVector<QVector<QPoint> > findMatches(const QRect &where,
+                                          int onlyRule = -1,
+                                          qint64 *candidates = 0) const;
+
+    /**
+     * Finds the matches of all rules within one of \a bandCount horizontal
+     * bands of the area around \a where. Only reads from the working map, so
+     * it can be called from multiple threads at once.
+     *
+     * \a onlyRule and \a candidates are used as by findMatches().
+     */
+    QVector<QVector<QPoint> > findMatchesInBand(const QRect &where,
+                                                int band,
+                                                int bandCount,
+                                                int onlyRule,
+                                                qint64 *candidates) const;
+
+    /**
+     * Matches and applies each rule near \a where in turn, while collecting
+     * their profiles.
+     * @return the rectangle where the rules actually got applied
+     */
+    QRect profileRules(const QRect &where);
+
+    /**
+     * Applies the rule at each of the given \a matches, in order.
+     * @return the rectangle where the rule actually got applied
+     */
+    QRect applyMatches(int ruleIndex, const QVector<QPoint> &matches);
+
+    /**
+     * Applies the output of the rule at the given position, unless that
+     * would overlap with \a appliedRegions while "NoOverlappingRules" is set.
+     * @return whether the rule was applied
+     */
+    bool applyRuleAt(int ruleIndex, const QPoint &pos,
+                     QVector<OccupancyBitmap> &appliedRegions);
+
+    /**
+     * Chooses which of the alternative outputs to use when applying the rule
+     * at the given position. Returns an index into mLayerList.
+     */
+    int chooseOutput(int ruleIndex, const QPoint &pos) const;
+
+    /**
+     * Returns the region covered by the given output \a layer of the rules
+     * map. Since the rules map doesn't change, the region is computed only
+     * once for each layer.
+     */
+    const QRegion &outputLayerRegion(Layer *layer);
+
+    /**
+     * Returns the rects making up the part of the output of the given rule
+     * that is covered by the given output \a layer. Cached like
+     * outputLayerRegion().
+     */
+    const QVector<QRect> &ruleOutputRects(int ruleIndex, Layer *layer);
+
     /**
      * Cleans up the data structes filled by setupRuleMapLayers(),
      * so the next rule can be processed.
@@ -279,11 +568,23 @@ private:
      */
     QVector<Tileset*> mAddedTilesets;
 
+    /**
+     * The tilesets of the rules map that are replaced by a similar tileset
+     * of the working map, filled by setupTilesets().
+     */
+    QHash<Tileset*, Tileset*> mTilesetReplacements;
+
     /**
      * description see: mAddedTilesets, just described by Strings
      */
     QList<QString> mAddedTileLayers;
 
+    /**
+     * The objects copied by copyObjectRegion() that still need to be added
+     * to each object group of the working map.
+     */
+    QMap<ObjectGroup*, QList<MapObject*> > mCopiedObjects;
+
     /**
      * Points to the tilelayer, which defines the inputregions.
      */
@@ -314,6 +615,50 @@ private:
      */
     QList<QRegion> mRulesOutput;
 
+    /**
+     * The largest distance outside of the area passed to applyRule() at
+     * which any rule may change the map.
+     */
+    int mRuleChangeMargin;
+
+    /**
+     * The compiled input of each rule, matching the indexes of mRulesInput.
+     * Set up by prepareAutoMap().
+     */
+    QVector<CompiledRule> mCompiledRules;
+
+    /**
+     * The names of the layers in the working map that the compiled rules
+     * are compared to, and the layers themselves as of the last call to
+     * resolveSetLayers().
+     */
+    QStringList mSetLayerNames;
+    QVector<const TileLayer*> mSetLayers;
+
+    /**
+     * For each set layer, maps the cells to the rules which require that
+     * cell at a certain position (their anchor). Rules are only compared to
+     * the working map at the places where it has one of their anchor cells.
+     */
+    QVector<QHash<quint64, QVector<RuleAnchor> > > mAnchors;
+
+    /**
+     * The rules having an alternative without any required cell, which need
+     * to be compared to the working map at every position.
+     */
+    QVector<int> mUnanchoredRules;
+
+    /**
+     * The regions covered by the output layers of the rules map, filled in
+     * as needed by outputLayerRegion().
+     */
+    QHash<Layer*, QRegion> mOutputLayerRegions;
+
+    /**
+     * The rects returned by ruleOutputRects(), by rule index and layer.
+     */
+    QHash<QPair<int, Layer*>, QVector<QRect> > mRuleOutputRects;
+
     /**
      * The inner set with layers to indexes is needed for translating
      * tile layers from mMapRules to mMapWork.
@@ -354,6 +699,25 @@ private:
      */
     bool mNoOverlappingRules;
 
+    /**
+     * Whether any output layer is also read by the rules, in which case the
+     * matches can not be searched for before applying the rules.
+     */
+    bool mOutputFeedsInput;
+
+    int mThreadCount;
+
+    uint mRandomSeed;
+
+    bool mProfiling;
+    QVector<RuleProfile> mRuleProfiles;
+
+    /**
+     * The profile of the rule currently being applied, or 0 when not
+     * profiling.
+     */
+    RuleProfile *mProfile;
+
     QSet<QString> mTouchedTileLayers;
 
     QSet<QString> mTouchedObjectGroups;
@@ -46,25 +46,44 @@ AutoMapperWrapper::AutoMapperWrapper(MapDocument *mapDocument,
             autoMapper.remove(index);
         }
     }
+    // Only the area that can be changed by the automapping is remembered,
+    // so that automapping while drawing does not need to copy and compare
+    // whole layers.
+    int margin = 0;
+    foreach (AutoMapper *a, autoMapper)
+        margin += a->changeMargin();
+
+    const QRect window = where->boundingRect().adjusted(-margin, -margin,
+                                                        margin, margin);
+
+    QVector<QRect> areas;
     foreach (const QString &layerName, touchedLayers) {
         const int layerindex = map->indexOfLayer(layerName);
         Q_ASSERT(layerindex != -1);
-        mLayersBefore << static_cast<TileLayer*>(map->layerAt(layerindex)->clone());
+        TileLayer *layer = map->layerAt(layerindex)->asTileLayer();
+        const QRect area = window.translated(-layer->position())
+                .intersected(QRect(0, 0, layer->width(), layer->height()));
+        areas.append(area);
+        mLayersBefore << layer->copy(area);
     }
 
     foreach (AutoMapper *a, autoMapper) {
         a->autoMap(where);
     }
 
+    int i = 0;
     foreach (const QString &layerName, touchedLayers) {
         const int layerindex = map->indexOfLayer(layerName);
         // layerindex exists, because AutoMapper is still alive, dont check
         Q_ASSERT(layerindex != -1);
-        mLayersAfter << static_cast<TileLayer*>(map->layerAt(layerindex)->clone());
+        TileLayer *layer = map->layerAt(layerindex)->asTileLayer();
+        mLayersAfter << layer->copy(areas.at(i++));
     }
+
     // reduce memory usage by saving only diffs
     Q_ASSERT(mLayersAfter.size() == mLayersBefore.size());
-    for (int i = 0; i < mLayersAfter.size(); ++i) {
+    i = 0;
+    foreach (const QString &layerName, touchedLayers) {
         TileLayer *before = mLayersBefore.at(i);
         TileLayer *after = mLayersAfter.at(i);
         QRect diffRegion = before->computeDiffRegion(after).boundingRect();
@@ -72,17 +91,25 @@ AutoMapperWrapper::AutoMapperWrapper(MapDocument *mapDocument,
         TileLayer *before1 = before->copy(diffRegion);
         TileLayer *after1 = after->copy(diffRegion);
 
-        before1->setPosition(diffRegion.topLeft());
-        after1->setPosition(diffRegion.topLeft());
-        before1->setName(before->name());
-        after1->setName(after->name());
+        const Layer *layer = map->layerAt(map->indexOfLayer(layerName));
+        const QPoint pos = layer->position() + areas.at(i).topLeft() +
+                diffRegion.topLeft();
+
+        before1->setPosition(pos);
+        after1->setPosition(pos);
+        before1->setName(layerName);
+        after1->setName(layerName);
         mLayersBefore.replace(i, before1);
         mLayersAfter.replace(i, after1);
 
         delete before;
         delete after;
+        ++i;
     }
 
+    mCellsBefore.resize(mLayersBefore.size());
+    mCellsAfter.resize(mLayersAfter.size());
+
     foreach (AutoMapper *a, autoMapper) {
         a->cleanAll();
     }
@@ -99,25 +126,46 @@ AutoMapperWrapper::~AutoMapperWrapper()
 
 void AutoMapperWrapper::undo()
 {
-    Map *map = mMapDocument->map();
-    QVector<TileLayer*>::iterator i;
-    for (i = mLayersBefore.begin(); i != mLayersBefore.end(); ++i) {
-        const int layerindex = map->indexOfLayer((*i)->name());
-        if (layerindex != -1)
-            patchLayer(layerindex, *i);
-    }
+    patchLayers(mLayersBefore, mCellsBefore);
+    memoryUsageChanged();
 }
 
 void AutoMapperWrapper::redo()
 {
-    Map *map = mMapDocument->map();
-    QVector<TileLayer*>::iterator i;
-    for (i = mLayersAfter.begin(); i != mLayersAfter.end(); ++i) {
-        const int layerindex = (map->indexOfLayer((*i)->name()));
-        if (layerindex != -1)
-            patchLayer(layerindex, *i);
+    patchLayers(mLayersAfter, mCellsAfter);
+    memoryUsageChanged();
+}
+
+qint64 AutoMapperWrapper::memoryUsage() const
+{
+    qint64 usage = 0;
+    for (int i = 0; i < mLayersBefore.size(); ++i) {
+        usage += mCellsBefore.at(i).memoryUsage(mLayersBefore.at(i));
+        usage += mCellsAfter.at(i).memoryUsage(mLayersAfter.at(i));
     }
+    return usage;
+}
 
+void AutoMapperWrapper::compress()
+{
+    for (int i = 0; i < mLayersBefore.size(); ++i) {
+        mCellsBefore[i].compress(mLayersBefore.at(i));
+        mCellsAfter[i].compress(mLayersAfter.at(i));
+    }
+}
+
+void AutoMapperWrapper::patchLayers(const QVector<TileLayer*> &layers,
+                                    QVector<CompressedCells> &cells)
+{
+    Map *map = mMapDocument->map();
+    for (int i = 0; i < layers.size(); ++i) {
+        TileLayer *layer = layers.at(i);
+        const int layerindex = map->indexOfLayer(layer->name());
+        if (layerindex != -1) {
+            cells[i].decompress(layer);
+            patchLayer(layerindex, layer);
+        }
+    }
 }
 
 void AutoMapperWrapper::patchLayer(int layerIndex, TileLayer *layer)
@@ -130,5 +178,5 @@ void AutoMapperWrapper::patchLayer(int layerIndex, TileLayer *layer)
 
     t->setCells(b.left() - t->x(), b.top() - t->y(), layer,
                 b.translated(-t->position()));
-    mMapDocument->emitRegionChanged(b);
+    mMapDocument->emitRegionChanged(b, t);
 }
@@ -22,6 +22,8 @@
 #define AUTOMAPPERWRAPPER_H
 
 #include "automapper.h"
+#include "compressedcells.h"
+#include "undobudget.h"
 
 #include <QUndoCommand>
 #include <QVector>
@@ -39,7 +41,7 @@ class MapDocument;
  * This class will take a snapshot of the layers before and after the
  * automapping is done. In between instances of AutoMapper are doing the work.
  */
-class AutoMapperWrapper : public QUndoCommand
+class AutoMapperWrapper : public QUndoCommand, public CompressibleCommand
 {
 public:
     AutoMapperWrapper(MapDocument *mapDocument, QVector<AutoMapper*> autoMapper,
@@ -49,12 +51,19 @@ public:
     void undo();
     void redo();
 
+    qint64 memoryUsage() const;
+    void compress();
+
 private:
+    void patchLayers(const QVector<TileLayer*> &layers,
+                     QVector<CompressedCells> &cells);
     void patchLayer(int layerIndex, TileLayer *layer);
 
     MapDocument *mMapDocument;
     QVector<TileLayer*> mLayersAfter;
     QVector<TileLayer*> mLayersBefore;
+    QVector<CompressedCells> mCellsAfter;
+    QVector<CompressedCells> mCellsBefore;
 };
 
 } // namespace Internal
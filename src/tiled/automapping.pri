@@ -0,0 +1,71 @@
+# The AutoMapper and the parts of Tiled it depends on, for building it into
+# other programs than Tiled itself.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+contains(QT_CONFIG, opengl): QT += opengl
+
+SOURCES += $$PWD/abstracttool.cpp \
+    $$PWD/addremovelayer.cpp \
+    $$PWD/addremovemapobject.cpp \
+    $$PWD/addremovetileset.cpp \
+    $$PWD/automapper.cpp \
+    $$PWD/automapperwrapper.cpp \
+    $$PWD/automappingmanager.cpp \
+    $$PWD/automappingutils.cpp \
+    $$PWD/changemapobject.cpp \
+    $$PWD/changeproperties.cpp \
+    $$PWD/changetileselection.cpp \
+    $$PWD/compressedcells.cpp \
+    $$PWD/documentmanager.cpp \
+    $$PWD/filesystemwatcher.cpp \
+    $$PWD/floodfill.cpp \
+    $$PWD/geometry.cpp \
+    $$PWD/imagelayeritem.cpp \
+    $$PWD/languagemanager.cpp \
+    $$PWD/layermodel.cpp \
+    $$PWD/mapdocument.cpp \
+    $$PWD/mapdocumentactionhandler.cpp \
+    $$PWD/mapobjectitem.cpp \
+    $$PWD/mapobjectmodel.cpp \
+    $$PWD/mapscene.cpp \
+    $$PWD/mapview.cpp \
+    $$PWD/movelayer.cpp \
+    $$PWD/objectgroupitem.cpp \
+    $$PWD/objecttypes.cpp \
+    $$PWD/offsetlayer.cpp \
+    $$PWD/painttilelayer.cpp \
+    $$PWD/preferences.cpp \
+    $$PWD/renamelayer.cpp \
+    $$PWD/resizelayer.cpp \
+    $$PWD/resizemap.cpp \
+    $$PWD/resizemapobject.cpp \
+    $$PWD/tilelayeritem.cpp \
+    $$PWD/tilepainter.cpp \
+    $$PWD/tileselectionitem.cpp \
+    $$PWD/tilesetmanager.cpp \
+    $$PWD/tmxmapreader.cpp \
+    $$PWD/tmxmapwriter.cpp \
+    $$PWD/toolmanager.cpp \
+    $$PWD/undobudget.cpp \
+    $$PWD/utils.cpp \
+    $$PWD/zoomable.cpp
+
+HEADERS += $$PWD/abstracttool.h \
+    $$PWD/automapper.h \
+    $$PWD/automappingmanager.h \
+    $$PWD/documentmanager.h \
+    $$PWD/filesystemwatcher.h \
+    $$PWD/layermodel.h \
+    $$PWD/mapdocument.h \
+    $$PWD/mapdocumentactionhandler.h \
+    $$PWD/mapobjectmodel.h \
+    $$PWD/mapscene.h \
+    $$PWD/mapview.h \
+    $$PWD/preferences.h \
+    $$PWD/tileselectionitem.h \
+    $$PWD/tilesetmanager.h \
+    $$PWD/toolmanager.h \
+    $$PWD/undobudget.h \
+    $$PWD/zoomable.h
@@ -21,6 +21,7 @@
 #include "automappingmanager.h"
 
 #include "automapperwrapper.h"
+#include "filesystemwatcher.h"
 #include "map.h"
 #include "mapdocument.h"
 #include "tilelayer.h"
@@ -30,18 +31,39 @@
 
 #include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QStringList>
 #include <QTextStream>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+AutomappingRuleSet::~AutomappingRuleSet()
+{
+    qDeleteAll(autoMappers);
+}
+
+bool AutomappingRuleSet::isUpToDate() const
+{
+    QMap<QString, QDateTime>::const_iterator it = files.constBegin();
+    QMap<QString, QDateTime>::const_iterator it_end = files.constEnd();
+    for (; it != it_end; ++it)
+        if (QFileInfo(it.key()).lastModified() != it.value())
+            return false;
+    return true;
+}
+
 AutomappingManager *AutomappingManager::mInstance = 0;
 
 AutomappingManager::AutomappingManager(QObject *parent)
     : QObject(parent)
     , mMapDocument(0)
+    , mRuleSet(0)
+    , mWatcher(new FileSystemWatcher(this))
     , mLoaded(false)
+    , mProfiling(false)
 {
+    connect(mWatcher, SIGNAL(fileChanged(QString)),
+            SLOT(fileChanged(QString)));
 }
 
 AutomappingManager::~AutomappingManager()
@@ -92,9 +114,12 @@ void AutomappingManager::autoMapInternal(QRegion where, Layer *touchedLayer)
     }
 
     if (!mLoaded) {
-        const QString mapPath = QFileInfo(mMapDocument->fileName()).path();
-        const QString rulesFileName = mapPath + QLatin1String("/rules.txt");
-        if (loadFile(rulesFileName)) {
+        QString rulesFileName = mRulesFileName;
+        if (rulesFileName.isEmpty()) {
+            const QString mapPath = QFileInfo(mMapDocument->fileName()).path();
+            rulesFileName = mapPath + QLatin1String("/rules.txt");
+        }
+        if (loadRuleSet(rulesFileName)) {
             mLoaded = true;
         } else {
             emit errorsOccurred();
@@ -102,32 +127,41 @@ void AutomappingManager::autoMapInternal(QRegion where, Layer *touchedLayer)
         }
     }
 
+    const QVector<AutoMapper*> &autoMappers = mRuleSet->autoMappers;
+
     // use a pointer to the region, so each automapper can manipulate it and the
     // following automappers do see the impact
     QRegion *passedRegion = new QRegion(where);
 
     QVector<AutoMapper*> passedAutoMappers;
     if (touchedLayer) {
-        foreach (AutoMapper *a, mAutoMappers) {
+        foreach (AutoMapper *a, autoMappers) {
             if (a->ruleLayerNameUsed(touchedLayer->name()))
                 passedAutoMappers.append(a);
         }
     } else {
-        passedAutoMappers = mAutoMappers;
+        passedAutoMappers = autoMappers;
     }
     if (!passedAutoMappers.isEmpty()) {
+        // Pick different alternative outputs on each run, while keeping the
+        // choice within a run independent of the number of threads
+        const uint seed = uint(qrand())
+                ^ uint(QDateTime::currentMSecsSinceEpoch());
+        for (int i = 0; i < passedAutoMappers.size(); ++i)
+            passedAutoMappers.at(i)->setRandomSeed(seed + i);
+
         QUndoStack *undoStack = mMapDocument->undoStack();
         undoStack->beginMacro(tr("Apply AutoMap rules"));
         AutoMapperWrapper *aw = new AutoMapperWrapper(mMapDocument, passedAutoMappers, passedRegion);
         undoStack->push(aw);
         undoStack->endMacro();
     }
-    foreach (AutoMapper *automapper, mAutoMappers) {
+    foreach (AutoMapper *automapper, autoMappers) {
         mWarning += automapper->warningString();
         mError += automapper->errorString();
     }
 
-    mMapDocument->emitRegionChanged(*passedRegion);
+    mMapDocument->emitRegionChanged(*passedRegion, 0);
     delete passedRegion;
 
     if (!mWarning.isEmpty())
@@ -137,23 +171,95 @@ void AutomappingManager::autoMapInternal(QRegion where, Layer *touchedLayer)
         emit errorsOccurred();
 }
 
-bool AutomappingManager::loadFile(const QString &filePath)
+bool AutomappingManager::loadRuleSet(const QString &rulesFileName)
+{
+    const QString key = QFileInfo(rulesFileName).absoluteFilePath();
+
+    AutomappingRuleSet *ruleSet = mRuleSets.value(key);
+    if (ruleSet && !ruleSet->isUpToDate()) {
+        removeRuleSet(key);
+        ruleSet = 0;
+    }
+
+    if (!ruleSet) {
+        ruleSet = new AutomappingRuleSet;
+        if (!loadFile(rulesFileName, ruleSet)) {
+            mError += ruleSet->errors;
+            mWarning += ruleSet->warnings;
+            delete ruleSet;
+            return false;
+        }
+
+        mRuleSets.insert(key, ruleSet);
+        foreach (const QString &fileName, ruleSet->files.keys())
+            mWatcher->addPath(fileName);
+    }
+
+    // Problems with the rules are reported for each document using them,
+    // including when the rule set was loaded for another document
+    mError += ruleSet->errors;
+    mWarning += ruleSet->warnings;
+
+    mRuleSet = ruleSet;
+    foreach (AutoMapper *autoMapper, mRuleSet->autoMappers) {
+        autoMapper->setMapDocument(mMapDocument);
+        if (autoMapper->isProfiling() != mProfiling)
+            autoMapper->setProfiling(mProfiling);
+    }
+
+    return true;
+}
+
+void AutomappingManager::removeRuleSet(const QString &rulesFileName)
+{
+    AutomappingRuleSet *ruleSet = mRuleSets.take(rulesFileName);
+    if (!ruleSet)
+        return;
+
+    if (ruleSet == mRuleSet) {
+        mRuleSet = 0;
+        mLoaded = false;
+    }
+
+    foreach (const QString &fileName, ruleSet->files.keys())
+        mWatcher->removePath(fileName);
+
+    delete ruleSet;
+}
+
+void AutomappingManager::fileChanged(const QString &path)
+{
+    QHash<QString, AutomappingRuleSet*>::const_iterator it;
+    QStringList outdated;
+    for (it = mRuleSets.constBegin(); it != mRuleSets.constEnd(); ++it)
+        if (it.value()->files.contains(path))
+            outdated.append(it.key());
+
+    foreach (const QString &rulesFileName, outdated)
+        removeRuleSet(rulesFileName);
+}
+
+bool AutomappingManager::loadFile(const QString &filePath,
+                                  AutomappingRuleSet *ruleSet)
 {
     bool ret = true;
     const QString absPath = QFileInfo(filePath).path();
     QFile rulesFile(filePath);
 
     if (!rulesFile.exists()) {
-        mError += tr("No rules file found at:\n%1").arg(filePath)
-                  + QLatin1Char('\n');
+        ruleSet->errors += tr("No rules file found at:\n%1").arg(filePath)
+                           + QLatin1Char('\n');
         return false;
     }
     if (!rulesFile.open(QIODevice::ReadOnly)) {
-        mError += tr("Error opening rules file:\n%1").arg(filePath)
-                  + QLatin1Char('\n');
+        ruleSet->errors += tr("Error opening rules file:\n%1").arg(filePath)
+                           + QLatin1Char('\n');
         return false;
     }
 
+    ruleSet->files.insert(QFileInfo(filePath).absoluteFilePath(),
+                          QFileInfo(filePath).lastModified());
+
     QTextStream in(&rulesFile);
     QString line = in.readLine();
 
@@ -168,7 +274,8 @@ bool AutomappingManager::loadFile(const QString &filePath)
             rulePath = absPath + QLatin1Char('/') + rulePath;
 
         if (!QFileInfo(rulePath).exists()) {
-            mError += tr("File not found:\n%1").arg(rulePath) + QLatin1Char('\n');
+            ruleSet->errors += tr("File not found:\n%1").arg(rulePath)
+                               + QLatin1Char('\n');
             ret = false;
             continue;
         }
@@ -178,29 +285,32 @@ bool AutomappingManager::loadFile(const QString &filePath)
             Map *rules = mapReader.read(rulePath);
 
             if (!rules) {
-                mError += tr("Opening rules map failed:\n%1").arg(
+                ruleSet->errors += tr("Opening rules map failed:\n%1").arg(
                         mapReader.errorString()) + QLatin1Char('\n');
                 ret = false;
                 continue;
             }
 
+            ruleSet->files.insert(QFileInfo(rulePath).absoluteFilePath(),
+                                  QFileInfo(rulePath).lastModified());
+
             TilesetManager *tilesetManager = TilesetManager::instance();
             tilesetManager->addReferences(rules->tilesets());
 
             AutoMapper *autoMapper;
             autoMapper = new AutoMapper(mMapDocument, rules, rulePath);
 
-            mWarning += autoMapper->warningString();
+            ruleSet->warnings += autoMapper->warningString();
             const QString error = autoMapper->errorString(); 
             if (error.isEmpty()) {
-                mAutoMappers.append(autoMapper);
+                ruleSet->autoMappers.append(autoMapper);
             } else {
-                mError += error;
+                ruleSet->errors += error;
                 delete autoMapper;
             }
         }
         if (rulePath.endsWith(QLatin1String(".txt"), Qt::CaseInsensitive)) {
-            if (!loadFile(rulePath))
+            if (!loadFile(rulePath, ruleSet))
                 ret = false;
         }
     }
@@ -209,7 +319,13 @@ bool AutomappingManager::loadFile(const QString &filePath)
 
 void AutomappingManager::setMapDocument(MapDocument *mapDocument)
 {
-    cleanUp();
+    // The rule sets stay cached, but should no longer refer to the document
+    if (mRuleSet) {
+        foreach (AutoMapper *autoMapper, mRuleSet->autoMappers)
+            autoMapper->setMapDocument(0);
+        mRuleSet = 0;
+    }
+
     if (mMapDocument)
         mMapDocument->disconnect(this);
 
@@ -221,10 +337,39 @@ void AutomappingManager::setMapDocument(MapDocument *mapDocument)
     mLoaded = false;
 }
 
-void AutomappingManager::cleanUp()
+void AutomappingManager::setRulesFileName(const QString &fileName)
 {
-    foreach (const AutoMapper *autoMapper, mAutoMappers) {
-        delete autoMapper;
+    if (mRulesFileName == fileName)
+        return;
+
+    mRulesFileName = fileName;
+
+    if (mRuleSet) {
+        foreach (AutoMapper *autoMapper, mRuleSet->autoMappers)
+            autoMapper->setMapDocument(0);
+        mRuleSet = 0;
     }
-    mAutoMappers.clear();
+    mLoaded = false;
+}
+
+void AutomappingManager::setProfiling(bool enabled)
+{
+    mProfiling = enabled;
+
+    if (mRuleSet)
+        foreach (AutoMapper *autoMapper, mRuleSet->autoMappers)
+            autoMapper->setProfiling(enabled);
+}
+
+QVector<AutoMapper*> AutomappingManager::autoMappers() const
+{
+    if (mRuleSet)
+        return mRuleSet->autoMappers;
+    return QVector<AutoMapper*>();
+}
+
+void AutomappingManager::cleanUp()
+{
+    foreach (const QString &rulesFileName, mRuleSets.keys())
+        removeRuleSet(rulesFileName);
 }
@@ -21,6 +21,9 @@
 #ifndef AUTOMAPPINGMANAGER_H
 #define AUTOMAPPINGMANAGER_H
 
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
 #include <QRegion>
 #include <QSet>
 #include <QString>
@@ -40,8 +43,30 @@ class Tileset;
 namespace Internal {
 
 class AutoMapper;
+class FileSystemWatcher;
 class MapDocument;
 
+/**
+ * The AutoMappers set up for one rules file, along with the modification
+ * times of all the files they were loaded from and the problems found while
+ * loading them.
+ */
+class AutomappingRuleSet
+{
+public:
+    ~AutomappingRuleSet();
+
+    /**
+     * Returns whether none of the files has been modified since loading.
+     */
+    bool isUpToDate() const;
+
+    QVector<AutoMapper*> autoMappers;
+    QMap<QString, QDateTime> files;
+    QString errors;
+    QString warnings;
+};
+
 /**
  * This class is a superior class to the AutoMapper and AutoMapperWrapper class.
  * It uses these classes to do the whole automapping process.
@@ -69,6 +94,25 @@ public:
 
     void setMapDocument(MapDocument *mapDocument);
 
+    /**
+     * Sets the rules file to use. By default, the rules.txt file next to the
+     * map file is used, which is what an empty \a fileName falls back to.
+     */
+    void setRulesFileName(const QString &fileName);
+    QString rulesFileName() const { return mRulesFileName; }
+
+    /**
+     * Enables collecting the profile of each rule on the AutoMappers.
+     * \sa AutoMapper::setProfiling()
+     */
+    void setProfiling(bool enabled);
+
+    /**
+     * Returns the AutoMappers used for the current map document. Only valid
+     * after automapping was done on the document.
+     */
+    QVector<AutoMapper*> autoMappers() const;
+
     QString errorString() const { return mError; }
 
     QString warningString() const { return mWarning; }
@@ -87,6 +131,9 @@ signals:
 public slots:
     void autoMap(QRegion where, Layer *touchedLayer);
 
+private slots:
+    void fileChanged(const QString &path);
+
 private:
     Q_DISABLE_COPY(AutomappingManager)
 
@@ -107,9 +154,25 @@ private:
      * If a fileextension is txt, this file will be opened and searched for
      * rules again.
      *
+     * The loaded AutoMappers, the files they were loaded from and any errors
+     * or warnings are added to \a ruleSet.
+     *
+     * @return if the loading was successful: return true if it suceeded.
+     */
+    bool loadFile(const QString &filePath, AutomappingRuleSet *ruleSet);
+
+    /**
+     * Makes the rules loaded from the given rules file current, loading them
+     * when they are not cached yet or when any of their files changed.
+     *
      * @return if the loading was successful: return true if it suceeded.
      */
-    bool loadFile(const QString &filePath);
+    bool loadRuleSet(const QString &rulesFileName);
+
+    /**
+     * Removes the rule set stored for the given rules file from the cache.
+     */
+    void removeRuleSet(const QString &rulesFileName);
 
     /**
      * Applies automapping to the Region \a where, considering only layer
@@ -121,7 +184,7 @@ private:
     void autoMapInternal(QRegion where, Layer *touchedLayer);
 
     /**
-     * deletes all its data structures
+     * deletes all its data structures, including the cached rule sets
      */
     void cleanUp();
 
@@ -131,17 +194,35 @@ private:
     MapDocument *mMapDocument;
 
     /**
-     * For each new file of rules a new AutoMapper is setup. In this vector we
-     * can store all of the AutoMappers in order.
+     * The rule sets loaded so far, by the path of their rules file. They are
+     * shared between all map documents using the same rules file.
      */
-    QVector<AutoMapper*> mAutoMappers;
+    QHash<QString, AutomappingRuleSet*> mRuleSets;
+
+    /**
+     * The rule set used for the current map document.
+     */
+    AutomappingRuleSet *mRuleSet;
+
+    /**
+     * Watches the files of the loaded rule sets, to drop a rule set from
+     * the cache when any of its files changes.
+     */
+    FileSystemWatcher *mWatcher;
 
     /**
      * This tells you if the rules for the current map document were already
-     * loaded.
+     * looked up.
      */
     bool mLoaded;
 
+    /**
+     * The rules file set through setRulesFileName().
+     */
+    QString mRulesFileName;
+
+    bool mProfiling;
+
     /**
      * Contains all errors which occurred until canceling.
      * If mError is not empty, no serious result can be expected.
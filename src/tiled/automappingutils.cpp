@@ -22,40 +22,232 @@
 #include "automappingutils.h"
 
 #include "addremovemapobject.h"
+#include "map.h"
 #include "mapdocument.h"
 #include "mapobject.h"
 #include "objectgroup.h"
+#include "tile.h"
 
+#include <QPainterPath>
 #include <QUndoStack>
 
+#include <cmath>
+
 namespace Tiled {
 namespace Internal {
 
+/**
+ * Shapes touching the edge of a tile by less than this amount are not
+ * considered to cover the tile.
+ */
+static const qreal coverageEpsilon = 1e-6;
+
+/**
+ * Returns the range of tiles overlapped by the given \a rect. A rect without
+ * width or height still covers the tiles it lies on.
+ */
+static QRect tileRange(const QRectF &rect)
+{
+    const int left = (int) std::floor(rect.left() + coverageEpsilon);
+    const int top = (int) std::floor(rect.top() + coverageEpsilon);
+    const int right = (int) std::ceil(rect.right() - coverageEpsilon) - 1;
+    const int bottom = (int) std::ceil(rect.bottom() - coverageEpsilon) - 1;
+    return QRect(QPoint(left, top), QPoint(qMax(left, right),
+                                           qMax(top, bottom)));
+}
+
+static QRectF tileRect(int x, int y)
+{
+    return QRectF(x + coverageEpsilon, y + coverageEpsilon,
+                  1 - 2 * coverageEpsilon, 1 - 2 * coverageEpsilon);
+}
+
+/**
+ * Returns whether the line segment from \a a to \a b intersects \a rect,
+ * using Liang-Barsky clipping.
+ */
+static bool segmentIntersects(const QPointF &a, const QPointF &b,
+                              const QRectF &rect)
+{
+    const qreal dx = b.x() - a.x();
+    const qreal dy = b.y() - a.y();
+    const qreal p[4] = { -dx, dx, -dy, dy };
+    const qreal q[4] = { a.x() - rect.left(), rect.right() - a.x(),
+                         a.y() - rect.top(), rect.bottom() - a.y() };
+    qreal t0 = 0;
+    qreal t1 = 1;
+
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0) {
+            if (q[i] < 0)
+                return false;
+            continue;
+        }
+
+        const qreal t = q[i] / p[i];
+        if (p[i] < 0) {
+            if (t > t1)
+                return false;
+            t0 = qMax(t0, t);
+        } else {
+            if (t < t0)
+                return false;
+            t1 = qMin(t1, t);
+        }
+    }
+    return true;
+}
+
+namespace {
+
+/**
+ * Tests whether a tile is covered by a painter path.
+ */
+struct PathCoverage
+{
+    explicit PathCoverage(const QPainterPath &path) : path(path) {}
+
+    bool operator()(int x, int y) const
+    { return path.intersects(tileRect(x, y)); }
+
+    const QPainterPath &path;
+};
+
+/**
+ * Tests whether a tile is covered by the line segment from \a a to \a b.
+ */
+struct SegmentCoverage
+{
+    SegmentCoverage(const QPointF &a, const QPointF &b) : a(a), b(b) {}
+
+    bool operator()(int x, int y) const
+    { return segmentIntersects(a, b, tileRect(x, y)); }
+
+    const QPointF a;
+    const QPointF b;
+};
+
+} // anonymous namespace
+
+/**
+ * Adds the tiles within \a range for which \a covers returns true to
+ * \a region, merging the covered tiles of each row into horizontal runs.
+ */
+template <typename Coverage>
+static void addCoveredTiles(QRegion &region, const QRect &range,
+                            const Coverage &covers)
+{
+    for (int y = range.top(); y <= range.bottom(); ++y) {
+        int runStart = -1;
+        for (int x = range.left(); x <= range.right() + 1; ++x) {
+            const bool covered = x <= range.right() && covers(x, y);
+            if (covered && runStart == -1) {
+                runStart = x;
+            } else if (!covered && runStart != -1) {
+                region += QRect(runStart, y, x - runStart, 1);
+                runStart = -1;
+            }
+        }
+    }
+}
+
+QRegion tileRegionOfObject(const MapObject *object)
+{
+    if (const Tile *tile = object->tile()) {
+        // Tile objects are drawn with their bottom-left corner at their
+        // position, and their size is given by the tile image.
+        const ObjectGroup *objectGroup = object->objectGroup();
+        const Map *map = objectGroup ? objectGroup->map() : 0;
+        if (!map || map->tileWidth() <= 0 || map->tileHeight() <= 0)
+            return tileRange(object->bounds());
+
+        const qreal width = qreal(tile->width()) / map->tileWidth();
+        const qreal height = qreal(tile->height()) / map->tileHeight();
+        return tileRange(QRectF(object->x(), object->y() - height,
+                                width, height));
+    }
+
+    const QPolygonF &polygon = object->polygon();
+    QRegion region;
+
+    switch (object->shape()) {
+    case MapObject::Rectangle:
+        return tileRange(object->bounds());
+
+    case MapObject::Polygon:
+        if (polygon.size() >= 3) {
+            QPainterPath path;
+            path.addPolygon(polygon.translated(object->position()));
+            path.closeSubpath();
+            addCoveredTiles(region, tileRange(path.boundingRect()),
+                            PathCoverage(path));
+            return region;
+        }
+        // a polygon without area only covers its outline
+        // fall through
+
+    case MapObject::Polyline:
+        if (polygon.isEmpty())
+            return tileRange(object->bounds());
+
+        if (polygon.size() == 1) {
+            const QPointF point = polygon.first() + object->position();
+            return tileRange(QRectF(point, QSizeF(0, 0)));
+        }
+
+        for (int i = 1; i < polygon.size(); ++i) {
+            const QPointF a = polygon.at(i - 1) + object->position();
+            const QPointF b = polygon.at(i) + object->position();
+            addCoveredTiles(region, tileRange(QRectF(a, b).normalized()),
+                            SegmentCoverage(a, b));
+        }
+        return region;
+
+    case MapObject::Ellipse:
+        if (object->width() > 0 && object->height() > 0) {
+            QPainterPath path;
+            path.addEllipse(object->bounds());
+            addCoveredTiles(region, tileRange(object->bounds()),
+                            PathCoverage(path));
+            return region;
+        }
+        break;
+    }
+
+    return tileRange(object->bounds());
+}
+
 void eraseRegionObjectGroup(MapDocument *mapDocument,
-                                        ObjectGroup *layer,
-                                        const QRegion &where)
+                            ObjectGroup *layer,
+                            const QRegion &where)
 {
+    const QList<MapObject*> objects = objectsInRegion(layer, where);
+    if (objects.isEmpty())
+        return;
+
     QUndoStack *undo = mapDocument->undoStack();
+    undo->push(new RemoveMapObjects(mapDocument, objects));
+}
 
-    foreach (MapObject *obj, layer->objects()) {
-        // TODO: we are checking bounds, which is only correct for rectangles and
-        // tile objects. polygons and polylines are not covered correctly by this
-        // erase method (we are in fact deleting too many objects)
-        // TODO2: toAlignedRect may even break rects.
-        if (where.intersects(obj->bounds().toAlignedRect()))
-            undo->push(new RemoveMapObject(mapDocument, obj));
+/**
+ * Returns the tile region of an object that is part of \a layer. The region
+ * is cached in the spatial index of the layer, until the object changes.
+ */
+static QRegion cachedTileRegionOfObject(ObjectGroup *layer, MapObject *object)
+{
+    QRegion region;
+    if (!layer->cachedTileRegion(object, &region)) {
+        region = tileRegionOfObject(object);
+        layer->setCachedTileRegion(object, region);
     }
+    return region;
 }
 
 QRegion tileRegionOfObjectGroup(ObjectGroup *layer)
 {
     QRegion ret;
-    foreach (MapObject *obj, layer->objects()) {
-        // TODO: we are using bounds, which is only correct for rectangles and
-        // tile objects. polygons and polylines are not probably covering less
-        // tiles.
-        ret += obj->bounds().toAlignedRect();
-    }
+    foreach (MapObject *obj, layer->objects())
+        ret += cachedTileRegionOfObject(layer, obj);
     return ret;
 }
 
@@ -63,12 +255,14 @@ const QList<MapObject*> objectsInRegion(ObjectGroup *layer,
                                         const QRegion &where)
 {
     QList<MapObject*> ret;
-    foreach (MapObject *obj, layer->objects()) {
-        // TODO: we are checking bounds, which is only correct for rectangles and
-        // tile objects. polygons and polylines are not covered correctly by this
-        // erase method (we are in fact deleting too many objects)
-        // TODO2: toAlignedRect may even break rects.
-        if (where.intersects(obj->bounds().toAlignedRect()))
+    if (where.isEmpty())
+        return ret;
+
+    // The spatial index narrows down the candidates by their bounds, after
+    // which the tiles actually covered by each object are checked.
+    const QRectF bounds = where.boundingRect();
+    foreach (MapObject *obj, layer->objectsIntersecting(bounds)) {
+        if (where.intersects(cachedTileRegionOfObject(layer, obj)))
             ret += obj;
     }
     return ret;
@@ -41,6 +41,13 @@ void eraseRegionObjectGroup(MapDocument *mapDocument,
 
 QRegion tileRegionOfObjectGroup(ObjectGroup *layer);
 
+/**
+ * Returns the region of tiles covered by the given \a object. Polygons,
+ * polylines and ellipses only cover the tiles their shape overlaps, rather
+ * than all tiles within their bounding box.
+ */
+QRegion tileRegionOfObject(const MapObject *object);
+
 } // namespace Internal
 } // namespace Tiled
 
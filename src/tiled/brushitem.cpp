@@ -57,6 +57,7 @@ void BrushItem::setMapDocument(MapDocument *mapDocument)
 void BrushItem::setTileLayer(const TileLayer *tileLayer)
 {
     delete mTileLayer;
+    mFillPattern = FillPattern();
 
     if (tileLayer) {
         mTileLayer = static_cast<TileLayer*>(tileLayer->clone());
@@ -69,6 +70,18 @@ void BrushItem::setTileLayer(const TileLayer *tileLayer)
     update();
 }
 
+void BrushItem::setFill(const FillPattern &pattern, const QRegion &region)
+{
+    delete mTileLayer;
+    mTileLayer = 0;
+
+    mFillPattern = pattern;
+    mFillOrigin = region.boundingRect().topLeft();
+    mRegion = region;
+    updateBoundingRect();
+    update();
+}
+
 void BrushItem::setTileLayerPosition(const QPoint &pos)
 {
     if (!mTileLayer)
@@ -115,6 +128,30 @@ void BrushItem::paint(QPainter *painter,
 
         renderer->drawTileSelection(painter, mRegion, highlight,
                                     option->exposedRect);
+    } else if (!mFillPattern.isEmpty()) {
+        const QRectF &exposed = option->exposedRect;
+
+        // Include the tiles that extend into the exposed area
+        const QMargins drawMargins = mFillPattern.drawMargins();
+        const QRectF rect = exposed.adjusted(-drawMargins.right(),
+                                             -drawMargins.bottom(),
+                                             drawMargins.left(),
+                                             drawMargins.top());
+        const QRect exposedTiles =
+                renderer->pixelToTileBoundingRect(rect).toAlignedRect();
+
+        const QRegion visible = mRegion.intersected(exposedTiles);
+        if (!visible.isEmpty()) {
+            TileLayer *tileLayer = mFillPattern.createTileLayer(visible,
+                                                                mFillOrigin);
+            const qreal opacity = painter->opacity();
+            painter->setOpacity(0.75);
+            renderer->drawTileLayer(painter, tileLayer, exposed);
+            painter->setOpacity(opacity);
+            delete tileLayer;
+        }
+
+        renderer->drawTileSelection(painter, mRegion, highlight, exposed);
     } else {
         renderer->drawTileSelection(painter, mRegion, highlight,
                                     option->exposedRect);
@@ -134,10 +171,11 @@ void BrushItem::updateBoundingRect()
     mBoundingRect = mMapDocument->renderer()->boundingRect(bounds);
 
     // Adjust for amount of pixels tiles extend at the top and to the right
-    if (mTileLayer) {
+    if (mTileLayer || !mFillPattern.isEmpty()) {
         const Map *map = mMapDocument->map();
 
-        QMargins drawMargins = mTileLayer->drawMargins();
+        QMargins drawMargins = mTileLayer ? mTileLayer->drawMargins()
+                                          : mFillPattern.drawMargins();
         drawMargins.setTop(drawMargins.top() - map->tileHeight());
         drawMargins.setRight(drawMargins.right() - map->tileWidth());
 
@@ -22,6 +22,8 @@
 #ifndef BRUSHITEM_H
 #define BRUSHITEM_H
 
+#include "fillpattern.h"
+
 #include <QGraphicsItem>
 
 namespace Tiled {
@@ -58,6 +60,15 @@ public:
      */
     void setTileLayer(const TileLayer *tileLayer);
 
+    /**
+     * Makes this brush fill the given \a region with the cells of the given
+     * \a pattern, starting at the top-left of the region. Only the cells in
+     * the exposed part of the region are created, each time it is painted.
+     *
+     * Setting a tile layer clears the fill pattern.
+     */
+    void setFill(const FillPattern &pattern, const QRegion &region);
+
     /**
      * Returns the current tile layer.
      */
@@ -90,6 +101,8 @@ private:
 
     MapDocument *mMapDocument;
     TileLayer *mTileLayer;
+    FillPattern mFillPattern;
+    QPoint mFillOrigin;
     QRegion mRegion;
     QRectF mBoundingRect;
 };
@@ -42,7 +42,6 @@ BucketFillTool::BucketFillTool(QObject *parent)
                        QKeySequence(tr("F")),
                        parent)
     , mStamp(0)
-    , mFillOverlay(0)
     , mIsRandom(false)
 {
 }
@@ -50,7 +49,6 @@ BucketFillTool::BucketFillTool(QObject *parent)
 BucketFillTool::~BucketFillTool()
 {
     delete mStamp;
-    delete mFillOverlay;
 }
 
 void BucketFillTool::activate(MapScene *scene)
@@ -123,41 +121,17 @@ void BucketFillTool::tilePositionChanged(const QPoint &tilePos)
     if (mFillRegion.isEmpty())
         return;
 
-    if (mLastRandomStatus != mIsRandom)
+    // A random fill is rolled again on every move
+    if (mLastRandomStatus != mIsRandom || mIsRandom)
         fillRegionChanged = true;
 
-    if (!mFillOverlay) {
-        // Create a new overlay region
-        mFillOverlay = new TileLayer(QString(),
-                                     tileLayer->x(),
-                                     tileLayer->y(),
-                                     tileLayer->width(),
-                                     tileLayer->height());
-    }
-
-    // Paint the new overlay
-    TilePainter tilePainter(mapDocument(), mFillOverlay);
-    if (!mIsRandom) {
-        if (fillRegionChanged)
-            tilePainter.drawStamp(mStamp, mFillRegion);
-    } else {
-        TileLayer *stamp = getRandomTileLayer(mFillRegion);
-        tilePainter.drawStamp(stamp, mFillRegion);
-        delete stamp;
-        fillRegionChanged = true;
-    }
-
     if (fillRegionChanged) {
-        // Crop the overlay to the smallest possible size
-        const QRect fillBounds = mFillRegion.boundingRect();
-        mFillOverlay->resize(fillBounds.size(), -fillBounds.topLeft());
-        mFillOverlay->setX(fillBounds.x());
-        mFillOverlay->setY(fillBounds.y());
-
-        // Update the brush item to draw the overlay
-        brushItem()->setTileLayer(mFillOverlay);
+        // The brush item only creates the cells it needs to draw
+        mFillPattern = FillPattern(mStamp, mIsRandom, qrand());
+        brushItem()->setFill(mFillPattern, mFillRegion);
         mLastRandomStatus = mIsRandom;
     }
+
     // Create connections to know when the overlay should be cleared
     makeConnections();
 }
@@ -169,10 +143,20 @@ void BucketFillTool::mousePressed(QGraphicsSceneMouseEvent *event)
     if (!brushItem()->isVisible())
         return;
 
+    // Only a random fill needs its cells to be created, a stamp is repeated
+    // in the same way by FillTiles
+    TileLayer *fillStamp = mStamp;
+    if (mIsRandom) {
+        fillStamp = mFillPattern.createTileLayer(
+                    mFillRegion, mFillRegion.boundingRect().topLeft());
+    }
+
     FillTiles *fillTiles = new FillTiles(mapDocument(),
                                          currentTileLayer(),
                                          mFillRegion,
-                                         brushItem()->tileLayer());
+                                         fillStamp);
+    if (fillStamp != mStamp)
+        delete fillStamp;
 
     QRegion fillRegion(mFillRegion);
     mapDocument()->undoStack()->push(fillTiles);
@@ -186,7 +170,7 @@ void BucketFillTool::mouseReleased(QGraphicsSceneMouseEvent *)
 void BucketFillTool::modifiersChanged(Qt::KeyboardModifiers)
 {
     // Don't need to recalculate fill region if there was no fill region
-    if (!mFillOverlay)
+    if (mFillPattern.isEmpty())
         return;
 
     tilePositionChanged(tilePosition());
@@ -218,9 +202,6 @@ void BucketFillTool::setStamp(TileLayer *stamp)
     delete mStamp;
     mStamp = stamp;
 
-    if (mIsRandom)
-        updateRandomList();
-
     tilePositionChanged(tilePosition());
 }
 
@@ -231,8 +212,7 @@ void BucketFillTool::clearOverlay()
     clearConnections(mapDocument());
 
     brushItem()->setTileLayer(0);
-    delete mFillOverlay;
-    mFillOverlay = 0;
+    mFillPattern = FillPattern();
 
     mFillRegion = QRegion();
     brushItem()->setTileRegion(QRegion());
@@ -244,7 +224,7 @@ void BucketFillTool::makeConnections()
         return;
 
     // Overlay may need to be cleared if a region changed
-    connect(mapDocument(), SIGNAL(regionChanged(QRegion)),
+    connect(mapDocument(), SIGNAL(regionChanged(QRegion,Layer*)),
             this, SLOT(clearOverlay()));
 
     // Overlay needs to be cleared if we switch to another layer
@@ -262,7 +242,7 @@ void BucketFillTool::clearConnections(MapDocument *mapDocument)
     if (!mapDocument)
         return;
 
-    disconnect(mapDocument, SIGNAL(regionChanged(QRegion)),
+    disconnect(mapDocument, SIGNAL(regionChanged(QRegion,Layer*)),
                this, SLOT(clearOverlay()));
 
     disconnect(mapDocument, SIGNAL(currentLayerIndexChanged(int)),
@@ -279,50 +259,9 @@ void BucketFillTool::setRandom(bool value)
 
     mIsRandom = value;
 
-    if (mIsRandom)
-        updateRandomList();
-    else
-        mRandomList.clear();
-
     // Don't need to recalculate fill region if there was no fill region
-    if (!mFillOverlay)
+    if (mFillPattern.isEmpty())
         return;
 
     tilePositionChanged(tilePosition());
 }
-
-TileLayer *BucketFillTool::getRandomTileLayer(const QRegion &region) const
-{
-    QRect bb = region.boundingRect();
-    TileLayer *result = new TileLayer(QString(), bb.x(), bb.y(),
-                                      bb.width(), bb.height());
-
-    if (region.isEmpty() || mRandomList.empty())
-        return result;
-
-    foreach (const QRect &rect, region.rects()) {
-        for (int _x = rect.left(); _x <= rect.right(); ++_x) {
-            for (int _y = rect.top(); _y <= rect.bottom(); ++_y) {
-
-                result->setCell(_x - bb.x(),
-                                _y - bb.y(),
-                                mRandomList.at(rand() % mRandomList.size()));
-            }
-        }
-    }
-    return result;
-}
-
-void BucketFillTool::updateRandomList()
-{
-    mRandomList.clear();
-
-    if (!mStamp)
-        return;
-
-    for (int x = 0; x < mStamp->width(); x++)
-        for (int y = 0; y < mStamp->height(); y++)
-            if (!mStamp->cellAt(x, y).isEmpty())
-                mRandomList.append(mStamp->cellAt(x, y));
-}
-
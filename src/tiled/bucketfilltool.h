@@ -25,6 +25,7 @@
 
 #include "abstracttiletool.h"
 
+#include "fillpattern.h"
 #include "tilelayer.h"
 
 namespace Tiled {
@@ -83,9 +84,14 @@ private:
     void clearConnections(MapDocument *mapDocument);
 
     TileLayer *mStamp;
-    TileLayer *mFillOverlay;
     QRegion mFillRegion;
 
+    /**
+     * The pattern shown over mFillRegion. Its cells are only created for the
+     * visible part of the region, and for the whole region when filling.
+     */
+    FillPattern mFillPattern;
+
     bool mLastShiftStatus;
 
     /**
@@ -96,29 +102,10 @@ private:
     /**
      * Contains the value of mIsRandom at that time, when the latest call of
      * tilePositionChanged() took place.
-     * This variable is needed to detect if the random mode was changed during
-     * mFillOverlay being brushed at an area.
+     * This variable is needed to detect if the random mode was changed while
+     * the fill pattern was shown at an area.
      */
     bool mLastRandomStatus;
-
-    /**
-     * Contains all used random cells to use in random mode.
-     * The same cell can be in the list multiple times to make different
-     * random weights possible.
-     */
-    QList<Cell> mRandomList;
-
-    /**
-     * Updates the list of random cells.
-     * This is done by taking all non-null tiles from the original stamp mStamp.
-     */
-    void updateRandomList();
-
-    /**
-     * Returns a tile layer having random tiles placed at \a region.The
-     * caller is responsible for the returned tile layer.
-     */
-    TileLayer *getRandomTileLayer(const QRegion &region) const;
 };
 
 } // namespace Internal
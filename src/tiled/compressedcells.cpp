@@ -0,0 +1,97 @@
+/*
+ * compressedcells.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compressedcells.h"
+
+#include "compression.h"
+#include "tilelayer.h"
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+void CompressedCells::compress(TileLayer *layer)
+{
+    const int width = layer->width();
+    const int height = layer->height();
+
+    if (isCompressed() || width == 0 || height == 0)
+        return;
+
+    // Encode the cells as gids, against the tilesets in use by this layer
+    const GidMapper gidMapper(layer->usedTilesets().toList());
+
+    QByteArray gids;
+    gids.resize(width * height * sizeof(uint));
+    uint *gid = reinterpret_cast<uint*>(gids.data());
+
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            *gid++ = gidMapper.cellToGid(layer->cellAt(x, y));
+
+    const QByteArray data = Tiled::compress(gids, Zlib);
+    if (data.isNull())
+        return;
+
+    mGidMapper = gidMapper;
+    mSize = QSize(width, height);
+    mData = data;
+
+    layer->resize(QSize(0, 0), QPoint());
+}
+
+void CompressedCells::decompress(TileLayer *layer)
+{
+    if (!isCompressed())
+        return;
+
+    const int width = mSize.width();
+    const int height = mSize.height();
+    const int size = width * height * sizeof(uint);
+    const QByteArray gids = Tiled::decompress(mData, size);
+
+    layer->resize(mSize, QPoint());
+
+    // Should not fail, since the data was compressed by us
+    Q_ASSERT(gids.size() == size);
+    if (gids.size() == size) {
+        const uint *gid = reinterpret_cast<const uint*>(gids.constData());
+
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                bool ok;
+                const Cell cell = mGidMapper.gidToCell(*gid++, ok);
+                if (ok && !cell.isEmpty())
+                    layer->setCell(x, y, cell);
+            }
+        }
+    }
+
+    mGidMapper.clear();
+    mSize = QSize();
+    mData = QByteArray();
+}
+
+qint64 CompressedCells::memoryUsage(const TileLayer *layer) const
+{
+    if (isCompressed())
+        return mData.size();
+
+    return qint64(layer->width()) * layer->height() * sizeof(Cell);
+}
@@ -0,0 +1,80 @@
+/*
+ * compressedcells.h
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPRESSEDCELLS_H
+#define COMPRESSEDCELLS_H
+
+#include "gidmapper.h"
+
+#include <QByteArray>
+#include <QSize>
+
+namespace Tiled {
+
+class TileLayer;
+
+namespace Internal {
+
+/**
+ * Holds the cells of a tile layer that is kept aside by an undo command in
+ * compressed form. The cells are encoded as global tile IDs, using the
+ * tilesets used by the layer at the time it was compressed, and are then
+ * zlib compressed.
+ *
+ * While compressed, the layer itself has no cells. It should be
+ * decompressed before it is used again.
+ */
+class CompressedCells
+{
+public:
+    /**
+     * Returns whether the cells of a layer are currently held compressed.
+     */
+    bool isCompressed() const { return !mData.isNull(); }
+
+    /**
+     * Compresses the cells of the given \a layer, after which the layer is
+     * left without cells. Does nothing when the cells are already
+     * compressed.
+     */
+    void compress(TileLayer *layer);
+
+    /**
+     * Restores the cells of the given \a layer. Does nothing when the cells
+     * aren't compressed.
+     */
+    void decompress(TileLayer *layer);
+
+    /**
+     * Returns the approximate number of bytes taken by the cells of the
+     * given \a layer, taking into account whether they are compressed.
+     */
+    qint64 memoryUsage(const TileLayer *layer) const;
+
+private:
+    GidMapper mGidMapper;
+    QSize mSize;
+    QByteArray mData;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // COMPRESSEDCELLS_H
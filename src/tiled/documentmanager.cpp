@@ -24,6 +24,7 @@
 #include "abstracttool.h"
 #include "maprenderer.h"
 #include "toolmanager.h"
+#include "undobudget.h"
 
 #include <QTabWidget>
 #include <QUndoGroup>
@@ -51,6 +52,7 @@ DocumentManager::DocumentManager(QObject *parent)
     : QObject(parent)
     , mTabWidget(new QTabWidget)
     , mUndoGroup(new QUndoGroup(this))
+    , mUndoBudget(new UndoBudget(this))
     , mSelectedTool(0)
     , mSceneWithTool(0)
 {
@@ -41,6 +41,7 @@ namespace Internal {
 class MapDocument;
 class MapScene;
 class MapView;
+class UndoBudget;
 
 /**
  * This class controls the open documents.
@@ -67,6 +68,12 @@ public:
      */
     QUndoGroup *undoGroup() const { return mUndoGroup; }
 
+    /**
+     * Returns the budget that limits the memory used by the undo stacks in
+     * the undo group.
+     */
+    UndoBudget *undoBudget() const { return mUndoBudget; }
+
     /**
      * Returns the current map document, or 0 when there is none.
      */
@@ -152,6 +159,7 @@ private:
 
     QTabWidget *mTabWidget;
     QUndoGroup *mUndoGroup;
+    UndoBudget *mUndoBudget;
     AbstractTool *mSelectedTool;
     MapScene *mSceneWithTool;
 
@@ -233,7 +233,7 @@ void EditPolygonTool::mousePressed(QGraphicsSceneMouseEvent *event)
         mStart = event->scenePos();
 
         const QList<QGraphicsItem *> items = mapScene()->items(mStart);
-        mClickedObjectItem = first<MapObjectItem>(items);
+        mClickedObjectItem = mapScene()->objectItemsAt(mStart).value(0);
         mClickedHandle = first<PointHandle>(items);
         break;
     }
@@ -423,12 +423,8 @@ void EditPolygonTool::updateSelection(const QPointF &pos,
         // Allow selecting some map objects only when there aren't any selected
         QSet<MapObjectItem*> selectedItems;
 
-        foreach (QGraphicsItem *item, mapScene()->items(rect)) {
-            MapObjectItem *mapObjectItem = dynamic_cast<MapObjectItem*>(item);
-            if (mapObjectItem)
-                selectedItems.insert(mapObjectItem);
-        }
-
+        foreach (MapObjectItem *mapObjectItem, mapScene()->objectItemsIn(rect))
+            selectedItems.insert(mapObjectItem);
 
         QSet<MapObjectItem*> newSelection;
 
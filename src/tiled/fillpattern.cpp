@@ -0,0 +1,107 @@
+/*
+ * fillpattern.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fillpattern.h"
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+FillPattern::FillPattern()
+    : mRandom(false)
+    , mSeed(0)
+{
+}
+
+FillPattern::FillPattern(const TileLayer *stamp, bool random, uint seed)
+    : mRandom(random)
+    , mSeed(seed)
+{
+    if (!stamp || stamp->isEmpty())
+        return;
+
+    mStamp = QSharedPointer<TileLayer>(static_cast<TileLayer*>(stamp->clone()));
+
+    // The same cell can be in the list multiple times, which gives it a
+    // higher chance to be picked
+    if (mRandom) {
+        for (int x = 0; x < stamp->width(); ++x)
+            for (int y = 0; y < stamp->height(); ++y)
+                if (!stamp->cellAt(x, y).isEmpty())
+                    mRandomCells.append(stamp->cellAt(x, y));
+    }
+}
+
+/**
+ * Mixes the bits of the seed and the position, so that neighbouring
+ * positions get unrelated values.
+ */
+static uint positionHash(uint seed, int x, int y)
+{
+    uint h = seed ^ (uint(x) * 73856093u) ^ (uint(y) * 19349663u);
+    h ^= h >> 16;
+    h *= 0x45d9f3bu;
+    h ^= h >> 16;
+    h *= 0x45d9f3bu;
+    h ^= h >> 16;
+    return h;
+}
+
+Cell FillPattern::cellAt(int x, int y, const QPoint &origin) const
+{
+    if (!mStamp)
+        return Cell();
+
+    if (mRandom) {
+        const uint index = positionHash(mSeed, x, y) % mRandomCells.size();
+        return mRandomCells.at(index);
+    }
+
+    const int stampX = (x - origin.x()) % mStamp->width();
+    const int stampY = (y - origin.y()) % mStamp->height();
+    return mStamp->cellAt(stampX, stampY);
+}
+
+TileLayer *FillPattern::createTileLayer(const QRegion &region,
+                                        const QPoint &origin) const
+{
+    const QRect bounds = region.boundingRect();
+    TileLayer *result = new TileLayer(QString(), bounds.x(), bounds.y(),
+                                      bounds.width(), bounds.height());
+
+    if (!mStamp)
+        return result;
+
+    foreach (const QRect &rect, region.rects()) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                const Cell cell = cellAt(x, y, origin);
+                if (!cell.isEmpty())
+                    result->setCell(x - bounds.x(), y - bounds.y(), cell);
+            }
+        }
+    }
+
+    return result;
+}
+
+QMargins FillPattern::drawMargins() const
+{
+    return mStamp ? mStamp->drawMargins() : QMargins();
+}
@@ -0,0 +1,90 @@
+/*
+ * fillpattern.h
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILLPATTERN_H
+#define FILLPATTERN_H
+
+#include "tilelayer.h"
+
+#include <QMargins>
+#include <QRegion>
+#include <QSharedPointer>
+#include <QVector>
+
+namespace Tiled {
+namespace Internal {
+
+/**
+ * Describes the cells placed by a bucket fill, without storing them for the
+ * whole filled region. The cells are derived from a stamp, which is either
+ * repeated, or from which a random cell is picked for each position.
+ *
+ * The pattern starts at a given origin, which is the top-left corner of the
+ * bounding rect of the filled region. A random pattern always gives the same
+ * cell for the same position, so that a preview matches what is filled.
+ */
+class FillPattern
+{
+public:
+    /**
+     * Constructs an empty pattern.
+     */
+    FillPattern();
+
+    /**
+     * Constructs a pattern based on the given \a stamp. When \a random is
+     * false, the stamp is repeated. Otherwise, each position gets a random
+     * non-empty cell of the stamp, determined by the \a seed.
+     */
+    FillPattern(const TileLayer *stamp, bool random, uint seed = 0);
+
+    bool isEmpty() const { return !mStamp; }
+
+    /**
+     * Returns the cell placed at \a x, \a y when the pattern starts at
+     * \a origin.
+     */
+    Cell cellAt(int x, int y, const QPoint &origin) const;
+
+    /**
+     * Returns a new tile layer at the bounding rect of \a region, with the
+     * cells of this pattern placed within \a region. The caller is
+     * responsible for deleting the returned tile layer.
+     */
+    TileLayer *createTileLayer(const QRegion &region,
+                               const QPoint &origin) const;
+
+    /**
+     * Returns the margins that have to be taken into account while drawing
+     * the cells of this pattern.
+     */
+    QMargins drawMargins() const;
+
+private:
+    QSharedPointer<TileLayer> mStamp;
+    QVector<Cell> mRandomCells;
+    bool mRandom;
+    uint mSeed;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // FILLPATTERN_H
@@ -0,0 +1,236 @@
+/*
+ * floodfill.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "floodfill.h"
+
+#include "tilelayer.h"
+
+#include <QVector>
+#include <QtAlgorithms>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace {
+
+/**
+ * A grid of bits, one for each cell of a rectangular area.
+ */
+class BitGrid
+{
+public:
+    BitGrid()
+        : mWordsPerRow(0)
+    {}
+
+    explicit BitGrid(const QSize &size)
+        : mWordsPerRow((size.width() + 31) / 32)
+        , mWords(mWordsPerRow * size.height(), 0)
+    {}
+
+    bool test(int x, int y) const
+    {
+        return mWords.at(y * mWordsPerRow + (x >> 5)) & (1u << (x & 31));
+    }
+
+    /**
+     * Sets the bits from \a left to \a right on row \a y.
+     */
+    void setRange(int y, int left, int right)
+    {
+        quint32 *row = mWords.data() + y * mWordsPerRow;
+        const int firstWord = left >> 5;
+        const int lastWord = right >> 5;
+
+        const quint32 firstMask = ~quint32(0) << (left & 31);
+        const quint32 lastMask = ~quint32(0) >> (31 - (right & 31));
+
+        if (firstWord == lastWord) {
+            row[firstWord] |= firstMask & lastMask;
+            return;
+        }
+
+        row[firstWord] |= firstMask;
+        for (int i = firstWord + 1; i < lastWord; ++i)
+            row[i] = ~quint32(0);
+        row[lastWord] |= lastMask;
+    }
+
+private:
+    int mWordsPerRow;
+    QVector<quint32> mWords;
+};
+
+/**
+ * The state of a single fill. Positions are relative to the fill area.
+ */
+class FillState
+{
+public:
+    FillState(const TileLayer *tileLayer, const QRect &area,
+              const QRegion &mask)
+        : mTileLayer(tileLayer)
+        , mArea(area)
+        , mLayerOffset(area.topLeft() - tileLayer->position())
+        , mMasked(!mask.isEmpty())
+        , mVisited(area.size())
+    {
+        if (!mMasked)
+            return;
+
+        // Rasterize the mask once, rather than testing the region per cell
+        mFillable = BitGrid(area.size());
+        foreach (const QRect &rect, mask.rects()) {
+            const QRect r = rect & area;
+            if (r.isEmpty())
+                continue;
+
+            for (int y = r.top(); y <= r.bottom(); ++y)
+                mFillable.setRange(y - area.top(),
+                                   r.left() - area.left(),
+                                   r.right() - area.left());
+        }
+    }
+
+    bool canFill(int x, int y) const
+    {
+        if (mVisited.test(x, y))
+            return false;
+        if (mMasked && !mFillable.test(x, y))
+            return false;
+        return cellAt(x, y) == mMatchCell;
+    }
+
+    QRegion fill(const QPoint &origin);
+
+private:
+    const Cell &cellAt(int x, int y) const
+    {
+        return mTileLayer->cellAt(x + mLayerOffset.x(),
+                                  y + mLayerOffset.y());
+    }
+
+    void pushSpans(int y, int left, int right);
+
+    const TileLayer *mTileLayer;
+    const QRect mArea;
+    const QPoint mLayerOffset;
+    const bool mMasked;
+    BitGrid mFillable;
+    BitGrid mVisited;
+    Cell mMatchCell;
+    QVector<QPoint> mStack;
+};
+
+bool runLessThan(const QRect &a, const QRect &b)
+{
+    if (a.top() != b.top())
+        return a.top() < b.top();
+    return a.left() < b.left();
+}
+
+QRegion FillState::fill(const QPoint &origin)
+{
+    const int width = mArea.width();
+    const int height = mArea.height();
+
+    // Cache cell that we will match other cells against
+    mMatchCell = cellAt(origin.x(), origin.y());
+    mStack.append(origin);
+
+    // The filled spans, as rects of one cell high
+    QVector<QRect> runs;
+
+    while (!mStack.isEmpty()) {
+        const QPoint seed = mStack.last();
+        mStack.pop_back();
+
+        const int y = seed.y();
+        if (!canFill(seed.x(), y))
+            continue;
+
+        // Seek as far left and right as we can
+        int left = seed.x();
+        while (left > 0 && canFill(left - 1, y))
+            --left;
+
+        int right = seed.x();
+        while (right < width - 1 && canFill(right + 1, y))
+            ++right;
+
+        mVisited.setRange(y, left, right);
+        runs.append(QRect(left + mArea.left(), y + mArea.top(),
+                          right - left + 1, 1));
+
+        if (y > 0)
+            pushSpans(y - 1, left, right);
+        if (y < height - 1)
+            pushSpans(y + 1, left, right);
+    }
+
+    // Spans on the same row never touch, since each one was extended as far
+    // as possible. Sorted, they are in the form expected by setRects().
+    qSort(runs.begin(), runs.end(), runLessThan);
+
+    QRegion region;
+    if (!runs.isEmpty())
+        region.setRects(runs.constData(), runs.size());
+    return region;
+}
+
+/**
+ * Pushes a seed for each span of fillable cells on row \a y between \a left
+ * and \a right.
+ */
+void FillState::pushSpans(int y, int left, int right)
+{
+    bool inSpan = false;
+    for (int x = left; x <= right; ++x) {
+        if (canFill(x, y)) {
+            if (!inSpan)
+                mStack.append(QPoint(x, y));
+            inSpan = true;
+        } else {
+            inSpan = false;
+        }
+    }
+}
+
+} // anonymous namespace
+
+FloodFill::FloodFill(const TileLayer *tileLayer, const QRegion &mask)
+    : mTileLayer(tileLayer)
+    , mMask(mask)
+{
+}
+
+QRegion FloodFill::compute(const QPoint &fillOrigin) const
+{
+    // Only the cells within the layer and the mask can be filled
+    QRect area = mTileLayer->bounds();
+    if (!mMask.isEmpty())
+        area &= mMask.boundingRect();
+
+    if (!area.contains(fillOrigin))
+        return QRegion();
+
+    FillState state(mTileLayer, area, mMask);
+    return state.fill(fillOrigin - area.topLeft());
+}
@@ -0,0 +1,68 @@
+/*
+ * floodfill.h
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FLOODFILL_H
+#define FLOODFILL_H
+
+#include <QRegion>
+
+namespace Tiled {
+
+class TileLayer;
+
+namespace Internal {
+
+/**
+ * Computes the region covered by a bucket fill, which is made up of all
+ * cells that are connected to the fill origin and match the cell found there.
+ *
+ * This is a scanline fill, which keeps a stack of spans that remain to be
+ * filled. The visited cells are tracked in a bitset covering only the area
+ * that may be filled, and the filled spans are turned into a region at once
+ * when done.
+ */
+class FloodFill
+{
+public:
+    /**
+     * Constructs a flood fill on the cells of the given \a tileLayer.
+     *
+     * @param tileLayer the tile layer of which the cells are compared
+     * @param mask      the region to which the fill is limited, in map
+     *                  coordinates, or an empty region to allow filling the
+     *                  whole layer
+     */
+    FloodFill(const TileLayer *tileLayer, const QRegion &mask = QRegion());
+
+    /**
+     * Returns the region filled when starting at \a fillOrigin, in map
+     * coordinates. The region is empty when the origin can't be filled.
+     */
+    QRegion compute(const QPoint &fillOrigin) const;
+
+private:
+    const TileLayer *mTileLayer;
+    QRegion mMask;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // FLOODFILL_H
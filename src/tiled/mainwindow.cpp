@@ -162,7 +162,8 @@ MainWindow::MainWindow(QWidget *parent, Qt::WFlags flags)
     undoAction->setIconText(tr("Undo"));
     connect(undoGroup, SIGNAL(cleanChanged(bool)), SLOT(updateWindowTitle()));
 
-    UndoDock *undoDock = new UndoDock(undoGroup, this);
+    UndoDock *undoDock = new UndoDock(undoGroup,
+                                      mDocumentManager->undoBudget(), this);
 
     addDockWidget(Qt::RightDockWidgetArea, mLayerDock);
     addDockWidget(Qt::RightDockWidgetArea, undoDock);
@@ -887,8 +888,7 @@ void MainWindow::cut()
     if (tileLayer && !tileSelection.isEmpty()) {
         stack->push(new EraseTiles(mMapDocument, tileLayer, tileSelection));
     } else if (!selectedObjects.isEmpty()) {
-        foreach (MapObject *mapObject, selectedObjects)
-            stack->push(new RemoveMapObject(mMapDocument, mapObject));
+        stack->push(new RemoveMapObjects(mMapDocument, selectedObjects));
     }
 
     mActionHandler->selectNone();
@@ -957,21 +957,21 @@ void MainWindow::paste()
                 insertPos = insertPos.toPoint();
             const QPointF offset = insertPos - center;
 
-            QUndoStack *undoStack = mMapDocument->undoStack();
             QList<MapObject*> pastedObjects;
 #if QT_VERSION >= 0x040700
             pastedObjects.reserve(objectGroup->objectCount());
 #endif
-            undoStack->beginMacro(tr("Paste Objects"));
             foreach (const MapObject *mapObject, objectGroup->objects()) {
                 MapObject *objectClone = mapObject->clone();
                 objectClone->setPosition(objectClone->position() + offset);
                 pastedObjects.append(objectClone);
-                undoStack->push(new AddMapObject(mMapDocument,
-                                                 currentObjectGroup,
-                                                 objectClone));
             }
-            undoStack->endMacro();
+
+            QUndoCommand *command = new AddMapObjects(mMapDocument,
+                                                      currentObjectGroup,
+                                                      pastedObjects);
+            command->setText(tr("Paste Objects"));
+            mMapDocument->undoStack()->push(command);
 
             mMapDocument->setSelectedObjects(pastedObjects);
         }
@@ -1000,8 +1000,7 @@ void MainWindow::delete_()
     if (tileLayer && !tileSelection.isEmpty()) {
         undoStack->push(new EraseTiles(mMapDocument, tileLayer, tileSelection));
     } else if (!selectedObjects.isEmpty()) {
-        foreach (MapObject *mapObject, selectedObjects)
-            undoStack->push(new RemoveMapObject(mMapDocument, mapObject));
+        undoStack->push(new RemoveMapObjects(mMapDocument, selectedObjects));
     }
 
     mActionHandler->selectNone();
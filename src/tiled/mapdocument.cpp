@@ -304,6 +304,24 @@ void MapDocument::mergeLayerDown()
     if (!lowerLayer->canMergeWith(upperLayer))
         return;
 
+    ObjectGroup *lowerObjectGroup = lowerLayer->asObjectGroup();
+    ObjectGroup *upperObjectGroup = upperLayer->asObjectGroup();
+    if (lowerObjectGroup && upperObjectGroup) {
+        // Move copies of the upper objects into the lower object group in one
+        // go, rather than replacing the lower object group with a copy
+        QList<MapObject*> objects;
+        foreach (const MapObject *mapObject, upperObjectGroup->objects())
+            objects.append(mapObject->clone());
+
+        mUndoStack->beginMacro(tr("Merge Layer Down"));
+        if (!objects.isEmpty())
+            mUndoStack->push(new AddMapObjects(this, lowerObjectGroup,
+                                               objects));
+        mUndoStack->push(new RemoveLayer(this, mCurrentLayerIndex));
+        mUndoStack->endMacro();
+        return;
+    }
+
     Layer *merged = lowerLayer->mergedWith(upperLayer);
 
     mUndoStack->beginMacro(tr("Merge Layer Down"));
@@ -402,6 +420,8 @@ void MapDocument::setTileSelection(const QRegion &selection)
     if (mTileSelection != selection) {
         const QRegion oldTileSelection = mTileSelection;
         mTileSelection = selection;
+        mTileSelectionBitmap.clear();
+        mTileSelectionBitmap.add(selection);
         emit tileSelectionChanged(mTileSelection, oldTileSelection);
     }
 }
@@ -470,9 +490,9 @@ void MapDocument::emitMapChanged()
     emit mapChanged();
 }
 
-void MapDocument::emitRegionChanged(const QRegion &region)
+void MapDocument::emitRegionChanged(const QRegion &region, Layer *layer)
 {
-    emit regionChanged(region);
+    emit regionChanged(region, layer);
 }
 
 void MapDocument::emitRegionEdited(const QRegion &region, Layer *layer)
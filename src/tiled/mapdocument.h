@@ -29,6 +29,7 @@
 #include <QString>
 
 #include "layer.h"
+#include "occupancybitmap.h"
 
 class QPoint;
 class QRect;
@@ -174,6 +175,13 @@ public:
      */
     const QRegion &tileSelection() const { return mTileSelection; }
 
+    /**
+     * Returns the selected area of tiles as a bitmap, for quickly testing
+     * whether a tile is selected. It is updated along with the selection.
+     */
+    const OccupancyBitmap &tileSelectionBitmap() const
+    { return mTileSelectionBitmap; }
+
     /**
      * Sets the selected area of tiles.
      */
@@ -209,8 +217,11 @@ public:
     /**
      * Emits the region changed signal for the specified region. The region
      * should be in tile coordinates. This method is used by the TilePainter.
+     *
+     * The \a layer is the layer that changed, or 0 when the change may affect
+     * multiple layers.
      */
-    void emitRegionChanged(const QRegion &region);
+    void emitRegionChanged(const QRegion &region, Layer *layer);
 
     /**
      * Emits the region edited signal for the specified region and tile layer.
@@ -265,9 +276,10 @@ signals:
 
     /**
      * Emitted when a certain region of the map changes. The region is given in
-     * tile coordinates.
+     * tile coordinates. The \a layer is the layer that changed, or 0 when the
+     * change may affect multiple layers.
      */
-    void regionChanged(const QRegion &region);
+    void regionChanged(const QRegion &region, Layer *layer);
 
     /**
      * Emitted when a certain region of the map was edited by user input.
@@ -301,6 +313,7 @@ private:
     Map *mMap;
     LayerModel *mLayerModel;
     QRegion mTileSelection;
+    OccupancyBitmap mTileSelectionBitmap;
     QList<MapObject*> mSelectedObjects;
     MapRenderer *mRenderer;
     int mCurrentLayerIndex;
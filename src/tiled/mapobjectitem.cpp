@@ -176,6 +176,7 @@ MapObjectItem::MapObjectItem(MapObject *object, MapDocument *mapDocument,
     QGraphicsItem(parent),
     mObject(object),
     mMapDocument(mapDocument),
+    mShapeRevision(0),
     mIsEditable(false),
     mSyncing(false),
     mResizeHandle(new ResizeHandle(this))
@@ -255,9 +256,14 @@ QRectF MapObjectItem::boundingRect() const
 
 QPainterPath MapObjectItem::shape() const
 {
-    QPainterPath path = mMapDocument->renderer()->shape(mObject);
-    path.translate(-pos());
-    return path;
+    // The scene asks for the shape a lot while hovering and selecting
+    if (mShapeRevision != mObject->revision() || mShapePos != pos()) {
+        mShape = mMapDocument->renderer()->shape(mObject);
+        mShape.translate(-pos());
+        mShapeRevision = mObject->revision();
+        mShapePos = pos();
+    }
+    return mShape;
 }
 
 void MapObjectItem::paint(QPainter *painter,
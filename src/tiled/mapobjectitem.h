@@ -110,6 +110,12 @@ private:
     QString mName;      // Copy of the name, so we know when it changes
     QPolygonF mPolygon; // Copy of the polygon, for the same reason
     QColor mColor;      // Cached color of the object
+
+    /** Shape cached in item coordinates, for the given revision and pos. */
+    mutable QPainterPath mShape;
+    mutable uint mShapeRevision;
+    mutable QPointF mShapePos;
+
     bool mIsEditable;
     bool mSyncing;
     ResizeHandle *mResizeHandle;
@@ -28,6 +28,10 @@
 #include "objectgroup.h"
 #include "renamelayer.h"
 
+#include <QHash>
+
+#include <algorithm>
+
 #define GROUPS_IN_DISPLAY_ORDER 1
 
 using namespace Tiled;
@@ -363,6 +367,109 @@ int MapObjectModel::removeObject(ObjectGroup *og, MapObject *o)
     return row;
 }
 
+/**
+ * Inserts the given \a objects into the object group \a og, each at the
+ * matching index in \a indexes. An index of -1 appends the object. The
+ * indexes need to be in ascending order, so that each object ends up at its
+ * given index.
+ *
+ * Consecutive indexes are inserted as a single range of rows, and the
+ * objectsAdded signal is emitted only once.
+ */
+void MapObjectModel::insertObjects(ObjectGroup *og, const QList<int> &indexes,
+                                   const QList<MapObject*> &objects)
+{
+    Q_ASSERT(indexes.size() == objects.size());
+
+    const QModelIndex parent = index(og);
+    int i = 0;
+    while (i < objects.size()) {
+        const bool append = indexes.at(i) < 0;
+        const int first = append ? og->objectCount() : indexes.at(i);
+
+        // Find the run of objects that ends up in consecutive rows
+        int last = i;
+        while (last + 1 < objects.size()) {
+            const int next = indexes.at(last + 1);
+            if (append ? next >= 0 : next != first + (last + 1 - i))
+                break;
+            ++last;
+        }
+
+        beginInsertRows(parent, first, first + (last - i));
+        for (int j = i; j <= last; ++j) {
+            MapObject *o = objects.at(j);
+            og->insertObject(first + (j - i), o);
+            mObjects.insert(o, new ObjectOrGroup(o));
+        }
+        endInsertRows();
+
+        i = last + 1;
+    }
+
+    emit objectsAdded(objects);
+}
+
+/**
+ * Removes the given \a objects from the object group \a og. Returns the
+ * index each of the objects had in the object group, in the same order as
+ * \a objects.
+ *
+ * Consecutive rows are removed as a single range, and the
+ * objectsAboutToBeRemoved and objectsRemoved signals are emitted only once.
+ */
+QList<int> MapObjectModel::removeObjects(ObjectGroup *og,
+                                         const QList<MapObject*> &objects)
+{
+    emit objectsAboutToBeRemoved(objects);
+
+    QHash<MapObject*, int> rowOfObject;
+    const QList<MapObject*> &groupObjects = og->objects();
+    for (int row = 0; row < groupObjects.size(); ++row)
+        rowOfObject.insert(groupObjects.at(row), row);
+
+    QList<int> rows;
+    foreach (MapObject *o, objects) {
+        const int row = rowOfObject.value(o, -1);
+        Q_ASSERT(row != -1);
+        rows.append(row);
+    }
+
+    // Remove from the bottom up, so that the remaining rows stay valid. An
+    // object listed more than once is only removed once.
+    QList<int> sortedRows = rows;
+    qSort(sortedRows.begin(), sortedRows.end(), qGreater<int>());
+    sortedRows.erase(std::unique(sortedRows.begin(), sortedRows.end()),
+                     sortedRows.end());
+
+    const QModelIndex parent = index(og);
+    int i = 0;
+    while (i < sortedRows.size()) {
+        const int last = sortedRows.at(i);
+        if (last < 0)
+            break;
+
+        int first = last;
+        int j = i + 1;
+        while (j < sortedRows.size() && sortedRows.at(j) == first - 1) {
+            --first;
+            ++j;
+        }
+
+        beginRemoveRows(parent, first, last);
+        for (int row = last; row >= first; --row) {
+            delete mObjects.take(og->objects().at(row));
+            og->removeObjectAt(row);
+        }
+        endRemoveRows();
+
+        i = j;
+    }
+
+    emit objectsRemoved(objects);
+    return rows;
+}
+
 // ObjectGroup color changed
 // FIXME: layerChanged should let the scene know that objects need redrawing
 void MapObjectModel::emitObjectsChanged(const QList<MapObject *> &objects)
@@ -89,6 +89,10 @@ public:
 
     void insertObject(ObjectGroup *og, int index, MapObject *o);
     int removeObject(ObjectGroup *og, MapObject *o);
+    void insertObjects(ObjectGroup *og, const QList<int> &indexes,
+                       const QList<MapObject*> &objects);
+    QList<int> removeObjects(ObjectGroup *og,
+                             const QList<MapObject*> &objects);
     void emitObjectsChanged(const QList<MapObject *> &objects);
 
     void setObjectName(MapObject *o, const QString &name);
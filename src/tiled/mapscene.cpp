@@ -53,6 +53,12 @@ using namespace Tiled::Internal;
 static const qreal darkeningFactor = 0.6;
 static const qreal opacityFactor = 0.4;
 
+/**
+ * The maximum amount of rects passed to QGraphicsScene::update() for all the
+ * regions that changed during a single event loop iteration.
+ */
+static const int maxRepaintRects = 16;
+
 MapScene::MapScene(QObject *parent):
     QGraphicsScene(parent),
     mMapDocument(0),
@@ -61,6 +67,7 @@ MapScene::MapScene(QObject *parent):
     mGridVisible(true),
     mUnderMouse(false),
     mCurrentModifiers(Qt::NoModifier),
+    mRepaintScheduled(false),
     mDarkRectangle(new QGraphicsRectItem),
     mDefaultBackgroundColor(Qt::darkGray)
 {
@@ -105,8 +112,8 @@ void MapScene::setMapDocument(MapDocument *mapDocument)
     if (mMapDocument) {
         connect(mMapDocument, SIGNAL(mapChanged()),
                 this, SLOT(mapChanged()));
-        connect(mMapDocument, SIGNAL(regionChanged(QRegion)),
-                this, SLOT(repaintRegion(QRegion)));
+        connect(mMapDocument, SIGNAL(regionChanged(QRegion,Layer*)),
+                this, SLOT(repaintRegion(QRegion,Layer*)));
         connect(mMapDocument, SIGNAL(layerAdded(int)),
                 this, SLOT(layerAdded(int)));
         connect(mMapDocument, SIGNAL(layerRemoved(int)),
@@ -138,6 +145,95 @@ void MapScene::setSelectedObjectItems(const QSet<MapObjectItem *> &items)
     mMapDocument->setSelectedObjects(selectedObjects);
 }
 
+QList<MapObjectItem*> MapScene::objectItemsAt(const QPointF &pos) const
+{
+    QList<MapObjectItem*> result;
+
+    foreach (MapObjectItem *item, candidateObjectItems(QRectF(pos, pos)))
+        if (item->shape().contains(pos - item->pos()))
+            result.append(item);
+
+    return result;
+}
+
+QList<MapObjectItem*> MapScene::objectItemsIn(const QRectF &rect) const
+{
+    QList<MapObjectItem*> result;
+
+    foreach (MapObjectItem *item, candidateObjectItems(rect))
+        if (item->shape().intersects(rect.translated(-item->pos())))
+            result.append(item);
+
+    return result;
+}
+
+static bool higherZValue(const MapObjectItem *a, const MapObjectItem *b)
+{
+    return a->zValue() > b->zValue();
+}
+
+/**
+ * Returns the visible map object items that may intersect the given scene
+ * \a rect, in the order in which they are stacked, topmost first.
+ */
+QList<MapObjectItem*> MapScene::candidateObjectItems(const QRectF &rect) const
+{
+    QList<MapObjectItem*> result;
+    if (!mMapDocument)
+        return result;
+
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const qreal margin = MapRenderer::objectMargin();
+    const QRectF area = rect.adjusted(-margin, -margin, margin, margin);
+    const QRectF tileArea = renderer->pixelToTileBoundingRect(area);
+
+    const Map *map = mMapDocument->map();
+    for (int i = map->layerCount() - 1; i >= 0; --i) {
+        ObjectGroup *objectGroup = map->layerAt(i)->asObjectGroup();
+        if (!objectGroup || !mLayerItems.at(i)->isVisible())
+            continue;
+
+        const QList<MapObject*> objects =
+                objectGroup->objectsIntersecting(tileArea);
+
+        // Later objects are stacked above earlier ones with the same z value
+        QList<MapObjectItem*> layerItems;
+        for (int j = objects.size() - 1; j >= 0; --j) {
+            MapObjectItem *item = itemForObject(objects.at(j));
+            if (item && item->isVisible())
+                layerItems.append(item);
+        }
+
+        qStableSort(layerItems.begin(), layerItems.end(), higherZValue);
+        result += layerItems;
+    }
+
+    return result;
+}
+
+QList<const TileLayer*> MapScene::occludingLayers(const TileLayer *layer) const
+{
+    QList<const TileLayer*> occluders;
+    if (!mMapDocument)
+        return occluders;
+
+    const Map *map = mMapDocument->map();
+    const int index = map->layers().indexOf(const_cast<TileLayer*>(layer));
+    if (index == -1)
+        return occluders;
+
+    // The opacity of the items also reflects the current layer highlighting
+    for (int i = map->layerCount() - 1; i > index; --i) {
+        const QGraphicsItem *item = mLayerItems.at(i);
+        if (!item->isVisible() || item->opacity() < 1)
+            continue;
+        if (const TileLayer *tileLayer = map->layerAt(i)->asTileLayer())
+            occluders.append(tileLayer);
+    }
+
+    return occluders;
+}
+
 void MapScene::setSelectedTool(AbstractTool *tool)
 {
     mSelectedTool = tool;
@@ -240,17 +336,78 @@ void MapScene::updateCurrentLayerHighlight()
     }
 }
 
-void MapScene::repaintRegion(const QRegion &region)
+void MapScene::repaintRegion(const QRegion &region, Layer *layer)
 {
     const MapRenderer *renderer = mMapDocument->renderer();
-    const QMargins margins = mMapDocument->map()->drawMargins();
+
+    // Only the tiles of the changed layer need to be taken into account. The
+    // layer may be unknown, in which case all tiles are considered.
+    QMargins margins;
+    if (TileLayer *tileLayer = layer ? layer->asTileLayer() : 0)
+        margins = tileLayer->drawMargins();
+    else
+        margins = mMapDocument->map()->drawMargins();
 
     foreach (const QRect &r, region.rects()) {
-        update(renderer->boundingRect(r).adjusted(-margins.left(),
-                                                  -margins.top(),
-                                                  margins.right(),
-                                                  margins.bottom()));
+        mPendingRepaint.append(renderer->boundingRect(r)
+                               .adjusted(-margins.left(),
+                                         -margins.top(),
+                                         margins.right(),
+                                         margins.bottom()));
+    }
+
+    if (!mRepaintScheduled && !mPendingRepaint.isEmpty()) {
+        mRepaintScheduled = true;
+        QMetaObject::invokeMethod(this, "flushRepaint", Qt::QueuedConnection);
+    }
+}
+
+void MapScene::flushRepaint()
+{
+    mRepaintScheduled = false;
+
+    const QVector<QRect> rects = mPendingRepaint;
+    mPendingRepaint.clear();
+
+    if (rects.size() <= maxRepaintRects) {
+        foreach (const QRect &r, rects)
+            update(r);
+        return;
     }
+
+    QRect bounds;
+    qint64 area = 0;
+    foreach (const QRect &r, rects) {
+        bounds |= r;
+        area += qint64(r.width()) * r.height();
+    }
+
+    // A single update is cheapest when it doesn't repaint much more than
+    // what actually changed.
+    if (qint64(bounds.width()) * bounds.height() <= 2 * area) {
+        update(bounds);
+        return;
+    }
+
+    // Otherwise, merge the rects within horizontal bands of equal height
+    const int bandHeight = (bounds.height() + maxRepaintRects - 1)
+            / maxRepaintRects;
+    QVector<QRect> bands(maxRepaintRects);
+
+    foreach (const QRect &r, rects) {
+        const int first = (r.top() - bounds.top()) / bandHeight;
+        const int last = (r.bottom() - bounds.top()) / bandHeight;
+
+        for (int i = first; i <= last; ++i) {
+            const QRect band(bounds.left(), bounds.top() + i * bandHeight,
+                             bounds.width(), bandHeight);
+            bands[i] |= r & band;
+        }
+    }
+
+    foreach (const QRect &band, bands)
+        if (!band.isEmpty())
+            update(band);
 }
 
 void MapScene::enableSelectedTool()
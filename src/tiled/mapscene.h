@@ -33,6 +33,7 @@ namespace Tiled {
 
 class Layer;
 class MapObject;
+class TileLayer;
 class Tileset;
 
 namespace Internal {
@@ -94,6 +95,28 @@ public:
     MapObjectItem *itemForObject(MapObject *object) const
     { return mObjectItems.value(object); }
 
+    /**
+     * Returns the visible map object items whose shape contains the given
+     * scene position \a pos, with the topmost item first.
+     *
+     * Uses the spatial index of the object groups, so it is much faster
+     * than QGraphicsScene::items() on layers with many objects.
+     */
+    QList<MapObjectItem*> objectItemsAt(const QPointF &pos) const;
+
+    /**
+     * Returns the visible map object items whose shape intersects the given
+     * scene \a rect, with the topmost item first.
+     */
+    QList<MapObjectItem*> objectItemsIn(const QRectF &rect) const;
+
+    /**
+     * Returns the tile layers that are drawn at full opacity above the given
+     * tile \a layer, topmost first. Opaque tiles on these layers hide the
+     * tiles below them, so those don't need to be drawn.
+     */
+    QList<const TileLayer*> occludingLayers(const TileLayer *layer) const;
+
     /**
      * Enables the selected tool at this map scene.
      * Therefore it tells that tool, that this is the active map scene.
@@ -144,9 +167,19 @@ private slots:
     void refreshScene();
 
     /**
-     * Repaints the specified region. The region is in tile coordinates.
+     * Schedules a repaint of the specified region of the given \a layer. The
+     * region is in tile coordinates. The layer may be 0, in which case the
+     * draw margins of the whole map are used.
+     *
+     * Repaints are accumulated and flushed once per event loop iteration.
+     */
+    void repaintRegion(const QRegion &region, Layer *layer);
+
+    /**
+     * Passes the accumulated repaint rects on to the scene, after merging
+     * them into a limited amount of rects.
      */
-    void repaintRegion(const QRegion &region);
+    void flushRepaint();
 
     void currentLayerIndexChanged();
 
@@ -166,6 +199,7 @@ private slots:
 
 private:
     QGraphicsItem *createLayerItem(Layer *layer);
+    QList<MapObjectItem*> candidateObjectItems(const QRectF &rect) const;
 
     void updateCurrentLayerHighlight();
 
@@ -180,6 +214,8 @@ private:
     Qt::KeyboardModifiers mCurrentModifiers;
     QPointF mLastMousePos;
     QVector<QGraphicsItem*> mLayerItems;
+    QVector<QRect> mPendingRepaint;
+    bool mRepaintScheduled;
     QGraphicsRectItem *mDarkRectangle;
     QColor mDefaultBackgroundColor;
 
@@ -164,11 +164,8 @@ void ObjectSelectionTool::updateSelection(const QPointF &pos,
 
     QSet<MapObjectItem*> selectedItems;
 
-    foreach (QGraphicsItem *item, mapScene()->items(rect)) {
-        MapObjectItem *mapObjectItem = dynamic_cast<MapObjectItem*>(item);
-        if (mapObjectItem)
-            selectedItems.insert(mapObjectItem);
-    }
+    foreach (MapObjectItem *mapObjectItem, mapScene()->objectItemsIn(rect))
+        selectedItems.insert(mapObjectItem);
 
     const QSet<MapObjectItem*> oldSelection = mapScene()->selectedObjectItems();
     QSet<MapObjectItem*> newSelection;
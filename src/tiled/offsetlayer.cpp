@@ -25,12 +25,50 @@
 #include "layermodel.h"
 #include "map.h"
 #include "mapdocument.h"
+#include "tilelayer.h"
 
 #include <QCoreApplication>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+/**
+ * Returns the part of \a layer within \a bounds that holds the cells which
+ * are moved out of the bounds, when offsetting the layer by \a offset.
+ */
+static QRegion lostRegion(const TileLayer *layer,
+                          const QPoint &offset,
+                          const QRect &bounds,
+                          bool wrapX, bool wrapY)
+{
+    const QRect area = bounds & QRect(0, 0, layer->width(), layer->height());
+    if (area.isEmpty())
+        return QRegion();
+
+    int dx = offset.x();
+    int dy = offset.y();
+    if (wrapX) {
+        dx %= bounds.width();
+        if (dx < 0)
+            dx += bounds.width();
+    }
+    if (wrapY) {
+        dy %= bounds.height();
+        if (dy < 0)
+            dy += bounds.height();
+    }
+
+    // A cell is kept when it ends up within the area, either directly or
+    // after wrapping around to the other side of the bounds
+    QRegion kept;
+    for (int i = 0; i < (wrapX ? 2 : 1); ++i)
+        for (int j = 0; j < (wrapY ? 2 : 1); ++j)
+            kept |= area.translated(i * bounds.width() - dx,
+                                    j * bounds.height() - dy);
+
+    return QRegion(area) - kept;
+}
+
 OffsetLayer::OffsetLayer(MapDocument *mapDocument,
                          int index,
                          const QPoint &offset,
@@ -41,12 +79,26 @@ OffsetLayer::OffsetLayer(MapDocument *mapDocument,
                                                "Offset Layer"))
     , mMapDocument(mapDocument)
     , mIndex(index)
+    , mOffset(offset)
+    , mBounds(bounds)
+    , mWrapX(wrapX)
+    , mWrapY(wrapY)
     , mOriginalLayer(0)
+    , mOffsetLayer(0)
 {
-    // Create the offset layer (once)
     Layer *layer = mMapDocument->map()->layerAt(mIndex);
-    mOffsetLayer = layer->clone();
-    mOffsetLayer->offset(offset, bounds, wrapX, wrapY);
+
+    if (TileLayer *tileLayer = layer->asTileLayer()) {
+        mLostRegion = lostRegion(tileLayer, offset, bounds, wrapX, wrapY)
+                .translated(tileLayer->position());
+        mLostCells.copyCells(tileLayer->x(), tileLayer->y(), tileLayer,
+                             mLostRegion, true);
+        memoryUsageChanged();
+    } else {
+        // Create the offset layer (once)
+        mOffsetLayer = layer->clone();
+        mOffsetLayer->offset(offset, bounds, wrapX, wrapY);
+    }
 }
 
 OffsetLayer::~OffsetLayer()
@@ -57,6 +109,16 @@ OffsetLayer::~OffsetLayer()
 
 void OffsetLayer::undo()
 {
+    Layer *layer = mMapDocument->map()->layerAt(mIndex);
+
+    if (TileLayer *tileLayer = layer->asTileLayer()) {
+        tileLayer->offset(-mOffset, mBounds, mWrapX, mWrapY);
+        mLostCells.apply(tileLayer, mLostRegion);
+        mMapDocument->emitRegionChanged(
+                    mBounds.translated(tileLayer->position()), tileLayer);
+        return;
+    }
+
     Q_ASSERT(!mOffsetLayer);
     mOffsetLayer = swapLayer(mOriginalLayer);
     mOriginalLayer = 0;
@@ -64,6 +126,15 @@ void OffsetLayer::undo()
 
 void OffsetLayer::redo()
 {
+    Layer *layer = mMapDocument->map()->layerAt(mIndex);
+
+    if (TileLayer *tileLayer = layer->asTileLayer()) {
+        tileLayer->offset(mOffset, mBounds, mWrapX, mWrapY);
+        mMapDocument->emitRegionChanged(
+                    mBounds.translated(tileLayer->position()), tileLayer);
+        return;
+    }
+
     Q_ASSERT(!mOriginalLayer);
     mOriginalLayer = swapLayer(mOffsetLayer);
     mOffsetLayer = 0;
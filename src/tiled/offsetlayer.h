@@ -22,7 +22,11 @@
 #ifndef OFFSETLAYER_H
 #define OFFSETLAYER_H
 
+#include "sparsecells.h"
+#include "undobudget.h"
+
 #include <QRect>
+#include <QRegion>
 #include <QPoint>
 #include <QUndoCommand>
 
@@ -36,8 +40,12 @@ class MapDocument;
 
 /**
  * Undo command that offsets a map layer.
+ *
+ * Tile layers are offset in place. Only the cells that are moved out of the
+ * bounds are remembered, since the offset can otherwise be reverted by
+ * offsetting in the opposite direction.
  */
-class OffsetLayer : public QUndoCommand
+class OffsetLayer : public QUndoCommand, public CompressibleCommand
 {
 public:
     /**
@@ -56,11 +64,23 @@ public:
     void undo();
     void redo();
 
+    qint64 memoryUsage() const { return mLostCells.memoryUsage(); }
+
 private:
     Layer *swapLayer(Layer *layer);
 
     MapDocument *mMapDocument;
     int mIndex;
+    QPoint mOffset;
+    QRect mBounds;
+    bool mWrapX;
+    bool mWrapY;
+
+    // The cells moved out of the bounds of a tile layer, in map coordinates
+    SparseCells mLostCells;
+    QRegion mLostRegion;
+
+    // Other layers are replaced by an offset copy
     Layer *mOriginalLayer;
     Layer *mOffsetLayer;
 };
@@ -37,34 +37,34 @@ PaintTileLayer::PaintTileLayer(MapDocument *mapDocument,
                                const TileLayer *source):
     mMapDocument(mapDocument),
     mTarget(target),
-    mSource(static_cast<TileLayer*>(source->clone())),
-    mX(x),
-    mY(y),
-    mPaintedRegion(x, y, source->width(), source->height()),
     mMergeable(false)
 {
-    mErased = mTarget->copy(mX - mTarget->x(),
-                            mY - mTarget->y(),
-                            mSource->width(), mSource->height());
+    // Only remember the cells that are painted, which skips the empty cells
+    // of the source layer
+    const QRegion sourceArea(x, y, source->width(), source->height());
+    mSource.copyCells(x, y, source, sourceArea, true);
+    mPaintedRegion = source->region().translated(x - source->x(),
+                                                 y - source->y());
+
+    mErased.copyCells(mTarget->x(), mTarget->y(), mTarget, mPaintedRegion);
     setText(QCoreApplication::translate("Undo Commands", "Paint"));
+    memoryUsageChanged();
 }
 
 PaintTileLayer::~PaintTileLayer()
 {
-    delete mSource;
-    delete mErased;
 }
 
 void PaintTileLayer::undo()
 {
     TilePainter painter(mMapDocument, mTarget);
-    painter.setCells(mX, mY, mErased, mPaintedRegion);
+    painter.setCells(mErased, mPaintedRegion);
 }
 
 void PaintTileLayer::redo()
 {
     TilePainter painter(mMapDocument, mTarget);
-    painter.drawCells(mX, mY, mSource);
+    painter.setCells(mSource, mPaintedRegion);
 }
 
 bool PaintTileLayer::mergeWith(const QUndoCommand *other)
@@ -75,33 +75,14 @@ bool PaintTileLayer::mergeWith(const QUndoCommand *other)
           o->mMergeable))
         return false;
 
+    // Only the tiles that were not painted before were newly erased
     const QRegion newRegion = o->mPaintedRegion.subtracted(mPaintedRegion);
-    const QRegion combinedRegion = mPaintedRegion.united(o->mPaintedRegion);
-    const QRect bounds = QRect(mX, mY, mSource->width(), mSource->height());
-    const QRect combinedBounds = combinedRegion.boundingRect();
-
-    // Resize the erased tiles and source layers when necessary
-    if (bounds != combinedBounds) {
-        const QPoint shift = bounds.topLeft() - combinedBounds.topLeft();
-        mErased->resize(combinedBounds.size(), shift);
-        mSource->resize(combinedBounds.size(), shift);
-    }
-
-    mX = combinedBounds.left();
-    mY = combinedBounds.top();
-    mPaintedRegion = combinedRegion;
-
-    // Copy the painted tiles from the other command over
-    const QPoint pos = QPoint(o->mX, o->mY) - combinedBounds.topLeft();
-    mSource->merge(pos, o->mSource);
+    mErased.merge(o->mErased, newRegion);
 
-    // Copy the newly erased tiles from the other command over
-    foreach (const QRect &rect, newRegion.rects())
-        for (int y = rect.top(); y <= rect.bottom(); ++y)
-            for (int x = rect.left(); x <= rect.right(); ++x)
-                mErased->setCell(x - mX,
-                                 y - mY,
-                                 o->mErased->cellAt(x - o->mX, y - o->mY));
+    // The tiles painted by the other command replace ours
+    mSource.merge(o->mSource);
+    mPaintedRegion |= o->mPaintedRegion;
+    memoryUsageChanged();
 
     return true;
 }
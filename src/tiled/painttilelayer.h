@@ -21,6 +21,8 @@
 #ifndef PAINTTILELAYER_H
 #define PAINTTILELAYER_H
 
+#include "sparsecells.h"
+#include "undobudget.h"
 #include "undocommands.h"
 
 #include <QRegion>
@@ -37,7 +39,7 @@ class MapDocument;
 /**
  * A command that paints one tile layer on top of another tile layer.
  */
-class PaintTileLayer : public QUndoCommand
+class PaintTileLayer : public QUndoCommand, public CompressibleCommand
 {
 public:
     /**
@@ -68,12 +70,24 @@ public:
     int id() const { return Cmd_PaintTileLayer; }
     bool mergeWith(const QUndoCommand *other);
 
+    /**
+     * The painted cells are already stored sparsely, so this command only
+     * reports its memory usage.
+     */
+    qint64 memoryUsage() const
+    { return mSource.memoryUsage() + mErased.memoryUsage(); }
+
 private:
     MapDocument *mMapDocument;
     TileLayer *mTarget;
-    TileLayer *mSource;
-    TileLayer *mErased;
-    int mX, mY;
+
+    /**
+     * The painted cells and the cells they replaced, only for the positions
+     * that were actually painted.
+     */
+    SparseCells mSource;
+    SparseCells mErased;
+
     QRegion mPaintedRegion;
     bool mMergeable;
 };
@@ -92,6 +92,11 @@ Preferences::Preferences()
                                        false).toBool();
     mSettings->endGroup();
 
+    mSettings->beginGroup(QLatin1String("Undo"));
+    mUndoMemoryLimit = mSettings->value(QLatin1String("MemoryLimit"),
+                                        256).toInt();
+    mSettings->endGroup();
+
     TilesetManager *tilesetManager = TilesetManager::instance();
     tilesetManager->setReloadTilesetsOnChange(mReloadTilesetsOnChange);
 }
@@ -306,3 +311,14 @@ void Preferences::setAutomappingDrawing(bool enabled)
     mAutoMapDrawing = enabled;
     mSettings->setValue(QLatin1String("Automapping/WhileDrawing"), enabled);
 }
+
+void Preferences::setUndoMemoryLimit(int megabytes)
+{
+    if (mUndoMemoryLimit == megabytes)
+        return;
+
+    mUndoMemoryLimit = megabytes;
+    mSettings->setValue(QLatin1String("Undo/MemoryLimit"), megabytes);
+
+    emit undoMemoryLimitChanged(megabytes);
+}
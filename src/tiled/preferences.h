@@ -81,6 +81,13 @@ public:
     bool automappingDrawing() const { return mAutoMapDrawing; }
     void setAutomappingDrawing(bool enabled);
 
+    /**
+     * Returns the memory limit for the undo history in megabytes. When it is
+     * exceeded, older undo commands are compressed. 0 means no limit.
+     */
+    int undoMemoryLimit() const { return mUndoMemoryLimit; }
+    void setUndoMemoryLimit(int megabytes);
+
     /**
      * Provides access to the QSettings instance to allow storing/retrieving
      * arbitrary values. The naming style for groups and keys is CamelCase.
@@ -105,6 +112,8 @@ signals:
 
     void objectTypesChanged();
 
+    void undoMemoryLimitChanged(int megabytes);
+
 private:
     Preferences();
     ~Preferences();
@@ -126,6 +135,8 @@ private:
 
     bool mAutoMapDrawing;
 
+    int mUndoMemoryLimit;
+
     static Preferences *mInstance;
 };
 
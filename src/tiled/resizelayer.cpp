@@ -24,6 +24,7 @@
 #include "layermodel.h"
 #include "map.h"
 #include "mapdocument.h"
+#include "tilelayer.h"
 
 #include <QCoreApplication>
 
@@ -38,12 +39,25 @@ ResizeLayer::ResizeLayer(MapDocument *mapDocument,
                                                "Resize Layer"))
     , mMapDocument(mapDocument)
     , mIndex(index)
+    , mSize(size)
+    , mOffset(offset)
     , mOriginalLayer(0)
+    , mResizedLayer(0)
 {
-    // Create the resized layer (once)
     Layer *layer = mMapDocument->map()->layerAt(mIndex);
-    mResizedLayer = layer->clone();
-    mResizedLayer->resize(size, offset);
+    mOriginalSize = QSize(layer->width(), layer->height());
+
+    if (TileLayer *tileLayer = layer->asTileLayer()) {
+        const QRect preserved(tileLayer->position() - offset, size);
+        mLostRegion = QRegion(tileLayer->bounds()) - preserved;
+        mLostCells.copyCells(tileLayer->x(), tileLayer->y(), tileLayer,
+                             mLostRegion, true);
+        memoryUsageChanged();
+    } else {
+        // Create the resized layer (once)
+        mResizedLayer = layer->clone();
+        mResizedLayer->resize(size, offset);
+    }
 }
 
 ResizeLayer::~ResizeLayer()
@@ -54,6 +68,17 @@ ResizeLayer::~ResizeLayer()
 
 void ResizeLayer::undo()
 {
+    Layer *layer = mMapDocument->map()->layerAt(mIndex);
+
+    if (TileLayer *tileLayer = layer->asTileLayer()) {
+        tileLayer->resize(mOriginalSize, -mOffset);
+        mLostCells.apply(tileLayer, mLostRegion);
+
+        // Makes the scene adapt to the new size of the layer
+        mMapDocument->emitMapChanged();
+        return;
+    }
+
     Q_ASSERT(!mResizedLayer);
     mResizedLayer = swapLayer(mOriginalLayer);
     mOriginalLayer = 0;
@@ -61,6 +86,14 @@ void ResizeLayer::undo()
 
 void ResizeLayer::redo()
 {
+    Layer *layer = mMapDocument->map()->layerAt(mIndex);
+
+    if (TileLayer *tileLayer = layer->asTileLayer()) {
+        tileLayer->resize(mSize, mOffset);
+        mMapDocument->emitMapChanged();
+        return;
+    }
+
     Q_ASSERT(!mOriginalLayer);
     mOriginalLayer = swapLayer(mResizedLayer);
     mResizedLayer = 0;
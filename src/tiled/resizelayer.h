@@ -21,7 +21,11 @@
 #ifndef RESIZELAYER_H
 #define RESIZELAYER_H
 
+#include "sparsecells.h"
+#include "undobudget.h"
+
 #include <QPoint>
+#include <QRegion>
 #include <QSize>
 #include <QUndoCommand>
 
@@ -35,8 +39,11 @@ class MapDocument;
 
 /**
  * Undo command that resizes a map layer.
+ *
+ * Tile layers are resized in place. Only the cells that fall outside of the
+ * new size are remembered, to be restored when resizing back.
  */
-class ResizeLayer : public QUndoCommand
+class ResizeLayer : public QUndoCommand, public CompressibleCommand
 {
 public:
     /**
@@ -53,11 +60,22 @@ public:
     void undo();
     void redo();
 
+    qint64 memoryUsage() const { return mLostCells.memoryUsage(); }
+
 private:
     Layer *swapLayer(Layer *layer);
 
     MapDocument *mMapDocument;
     int mIndex;
+    QSize mOriginalSize;
+    QSize mSize;
+    QPoint mOffset;
+
+    // The cells of a tile layer outside of the new size, in map coordinates
+    SparseCells mLostCells;
+    QRegion mLostRegion;
+
+    // Other layers are replaced by a resized copy
     Layer *mOriginalLayer;
     Layer *mResizedLayer;
 };
@@ -143,7 +143,10 @@ void SaveAsImageDialog::accept()
                                                    mCurrentScale));
     }
 
-    foreach (const Layer *layer, mMapDocument->map()->layers()) {
+    const QList<Layer*> &layers = mMapDocument->map()->layers();
+
+    for (int i = 0; i < layers.size(); ++i) {
+        const Layer *layer = layers.at(i);
         if (visibleLayersOnly && !layer->isVisible())
             continue;
 
@@ -154,9 +157,28 @@ void SaveAsImageDialog::accept()
         const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer);
 
         if (tileLayer) {
-            renderer->drawTileLayer(&painter, tileLayer);
+            // Skip drawing what will be covered by opaque tiles later on
+            QList<const TileLayer*> occluders;
+            for (int j = layers.size() - 1; j > i; --j) {
+                const Layer *above = layers.at(j);
+                if (visibleLayersOnly && !above->isVisible())
+                    continue;
+                if (above->opacity() < 1)
+                    continue;
+                if (const TileLayer *tl = dynamic_cast<const TileLayer*>(above))
+                    occluders.append(tl);
+            }
+
+            renderer->drawTileLayer(&painter, tileLayer, QRectF(), occluders);
         } else if (objGroup) {
-            foreach (const MapObject *object, objGroup->objects()) {
+            const QRectF mapRect(QPointF(), renderer->mapSize());
+            const QRectF tileRect = renderer->pixelToTileBoundingRect(mapRect);
+
+            foreach (const MapObject *object,
+                     objGroup->objectsIntersecting(tileRect)) {
+                if (!object->isVisible())
+                    continue;
+
                 const QColor color = MapObjectItem::objectColor(object);
                 renderer->drawMapObject(&painter, object, color);
             }
@@ -150,13 +150,13 @@ void StampBrush::configureBrush(const QVector<QPoint> &list)
     if (!mStamp)
         return;
 
-    QRegion reg;
-    QRegion stampRegion;
+    OccupancyBitmap reg;
+    QVector<QRect> stampRects;
 
     if (mIsRandom)
-        stampRegion = brushItem()->tileLayer()->region();
+        stampRects = brushItem()->tileLayer()->region().rects();
     else
-        stampRegion = mStamp->region();
+        stampRects = mStamp->region().rects();
 
     Map *map = mapDocument()->map();
 
@@ -164,10 +164,19 @@ void StampBrush::configureBrush(const QVector<QPoint> &list)
                                      map->width(), map->height());
 
     foreach (const QPoint p, list) {
-        const QRegion update = stampRegion.translated(p.x() - mStampX,
-                                                      p.y() - mStampY);
-        if (!reg.intersects(update)) {
-            reg += update;
+        const QPoint offset(p.x() - mStampX, p.y() - mStampY);
+
+        bool overlaps = false;
+        foreach (const QRect &rect, stampRects) {
+            if (reg.intersects(rect.translated(offset))) {
+                overlaps = true;
+                break;
+            }
+        }
+
+        if (!overlaps) {
+            foreach (const QRect &rect, stampRects)
+                reg.add(rect.translated(offset));
 
             if (mIsRandom) {
                 TileLayer *newStamp = getRandomTileLayer();
@@ -34,8 +34,10 @@
 #include "terrain.h"
 
 #include <math.h>
+#include <QAtomicInt>
+#include <QHash>
 #include <QVector>
-#include <climits>
+#include <QtConcurrentRun>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -54,10 +56,14 @@ TerrainBrush::TerrainBrush(QObject *parent)
     , mLineReferenceY(0)
 {
     setBrushMode(PaintTile);
+
+    connect(&mJobWatcher, SIGNAL(finished()), SLOT(brushUpdateFinished()));
 }
 
 TerrainBrush::~TerrainBrush()
 {
+    cancelBrushUpdate();
+    waitForCanceledBrushUpdates();
 }
 
 void TerrainBrush::tilePositionChanged(const QPoint &pos)
@@ -167,6 +173,10 @@ void TerrainBrush::mapDocumentChanged(MapDocument *oldDocument,
 {
     AbstractTileTool::mapDocumentChanged(oldDocument, newDocument);
 
+    // The computations may still refer to the tilesets of the old map
+    cancelBrushUpdate();
+    waitForCanceledBrushUpdates();
+
     // Reset the brush, since it probably became invalid
     brushItem()->setTileLayer(0);
 
@@ -207,6 +217,9 @@ void TerrainBrush::capture()
 
 void TerrainBrush::doPaint(bool mergeable, int whereX, int whereY)
 {
+    // Paint the brush for the current position, not a stale one
+    finishBrushUpdate();
+
     TileLayer *stamp = brushItem()->tileLayer();
 
     if (!stamp)
@@ -239,7 +252,7 @@ static inline unsigned int makeTerrain(int tl, int tr, int bl, int br)
     return (tl & 0xFF) << 24 | (tr & 0xFF) << 16 | (bl & 0xFF) << 8 | (br & 0xFF);
 }
 
-Tile *TerrainBrush::findBestTile(Tileset *tileset, unsigned int terrain, unsigned int considerationMask)
+static Tile *findBestTile(Tileset *tileset, unsigned int terrain, unsigned int considerationMask)
 {
     // we should have hooked 0xFFFFFFFF terrains outside this function
     Q_ASSERT(terrain != 0xFFFFFFFF);
@@ -248,125 +261,89 @@ Tile *TerrainBrush::findBestTile(Tileset *tileset, unsigned int terrain, unsigne
     if (terrain == 0xFFFFFFFF)
         return NULL;
 
-    QList<Tile*> matches;
-    int penalty = INT_MAX;
-
-    // TODO: this is a slow linear search, perhaps we could use a better find algorithm...
-    int tileCount = tileset->tileCount();
-    for (int i = 0; i < tileCount; ++i) {
-        Tile *t = tileset->tileAt(i);
-        if ((t->terrain() & considerationMask) != (terrain & considerationMask))
-            continue;
-
-        // calculate the tile transition penalty based on shortest distance to target terrain type
-        int tr = tileset->terrainTransitionPenalty(t->terrain() >> 24, terrain >> 24);
-        int tl = tileset->terrainTransitionPenalty((t->terrain() >> 16) & 0xFF, (terrain >> 16) & 0xFF);
-        int br = tileset->terrainTransitionPenalty((t->terrain() >> 8) & 0xFF, (terrain >> 8) & 0xFF);
-        int bl = tileset->terrainTransitionPenalty(t->terrain() & 0xFF, terrain & 0xFF);
-
-        // if there is no path to the destination terrain, this isn't a useful transition
-        if (tr < 0 || tl < 0 || br < 0 || bl < 0)
-            continue;
-
-        // add tile to the candidate list
-        int transitionPenalty = tr + tl + br + bl;
-        if (transitionPenalty <= penalty) {
-            if (transitionPenalty < penalty)
-                matches.clear();
-            penalty = transitionPenalty;
-
-            matches.push_back(t);
-        }
-    }
-
     // choose a candidate at random, with consideration for terrain probability
-    if (!matches.isEmpty()) {
+    const TerrainCandidates candidates =
+            tileset->terrainCandidates(terrain, considerationMask);
+    if (!candidates.isEmpty()) {
         float random = ((float)rand() / RAND_MAX) * 100.f;
-        float total = 0, unassigned = 0;
-
-        // allow the tiles with assigned probability to take their share
-        for (int i = 0; i < matches.size(); ++i) {
-            float probability = matches[i]->terrainProbability();
-            if (probability < 0.f) {
-                ++unassigned;
-                continue;
-            }
-            if (random < total + probability)
-                return matches[i];
-            total += probability;
-        }
-
-        // divide the remaining percentile by the numer of unassigned tiles
-        float remainingShare = (100.f - total) / (float)unassigned;
-        for (int i = 0; i < matches.size(); ++i) {
-            if (matches[i]->terrainProbability() >= 0.f)
-                continue;
-            if (random < total + remainingShare)
-                return matches[i];
-            total += remainingShare;
-        }
+        return candidates.tileAt(random);
     }
 
     // TODO: conveniently, the NULL tile doesn't currently work, but when it does, we need to signal a failure to find any matches some other way
     return NULL;
 }
 
-void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
+namespace Tiled {
+namespace Internal {
+
+/**
+ * A brush update, which is computed on a snapshot of the layer so that it can
+ * run in the background while the map is being edited.
+ */
+class TerrainBrushJob
 {
-    // get the current tile layer
-    TileLayer *currentLayer = currentTileLayer();
-    Q_ASSERT(currentLayer);
+public:
+    TerrainBrushJob()
+        : layer(0)
+        , terrain(0)
+        , brushMode(TerrainBrush::PaintTile)
+        , paintCorner(0)
+        , stamp(0)
+    {}
+
+    ~TerrainBrushJob()
+    {
+        delete layer;
+        delete stamp;
+    }
 
-    int layerWidth = currentLayer->width();
-    int layerHeight = currentLayer->height();
-    int numTiles = layerWidth * layerHeight;
-    int paintCorner = 0;
+    TileLayer *layer;
+    const Terrain *terrain;
+    TerrainBrush::BrushMode brushMode;
+    int paintCorner;
+    QPoint cursorPos;
+    QVector<QPoint> startPoints;
+    QAtomicInt canceled;
 
-    // if we are in vertex paint mode, the bottom right corner on the map will appear as an invalid tile offset...
-    if (mBrushMode == PaintVertex) {
-        if (cursorPos.x() == layerWidth) {
-            cursorPos.setX(cursorPos.x() - 1);
-            paintCorner |= 1;
-        }
-        if (cursorPos.y() == layerHeight) {
-            cursorPos.setY(cursorPos.y() - 1);
-            paintCorner |= 2;
-        }
-    }
+    TileLayer *stamp;
+    QRect brushRect;
+};
 
-    // if the cursor is outside of the map, bail out
-    if (!currentLayer->bounds().contains(cursorPos))
-        return;
+} // namespace Internal
+} // namespace Tiled
 
-    // TODO: this seems like a problem... there's nothing to say that 2 adjacent tiles are from the same tileset, or have any relation to eachother...
-    Tileset *terrainTileset = mTerrain ? mTerrain->tileset() : NULL;
+static void computeTerrainBrush(QSharedPointer<TerrainBrushJob> job)
+{
+    const TileLayer *layer = job->layer;
+    int layerWidth = layer->width();
+    int layerHeight = layer->height();
 
-    // allocate a buffer to build the terrain tilemap (TODO: this could be retained per layer to save regular allocation)
-    Tile **newTerrain = new Tile*[numTiles];
+    // TODO: this seems like a problem... there's nothing to say that 2 adjacent tiles are from the same tileset, or have any relation to eachother...
+    Tileset *terrainTileset = job->terrain ? job->terrain->tileset() : NULL;
 
-    // allocate a buffer of flags for each tile that may be considered (TODO: this could be retained per layer to save regular allocation)
-    char *checked = new char[numTiles];
-    memset(checked, 0, numTiles);
+    // the working set only covers the tiles that are considered, so that its
+    // size does not depend on the size of the layer. Each start point is
+    // usually painted, so make room for those up front.
+    QHash<int, Tile*> newTerrain;
+    newTerrain.reserve(job->startPoints.size());
 
     // create a consideration list, and push the start points
     QList<QPoint> transitionList;
     int initialTiles = 0;
 
-    if (list) {
-        // if we were supplied a list of start points
-        foreach (const QPoint &p, *list) {
-            transitionList.push_back(p);
-            ++initialTiles;
-        }
-    } else {
-        transitionList.push_back(cursorPos);
-        initialTiles = 1;
+    foreach (const QPoint &p, job->startPoints) {
+        transitionList.push_back(p);
+        ++initialTiles;
     }
 
-    QRect brushRect(cursorPos, cursorPos);
+    QRect brushRect(job->cursorPos, job->cursorPos);
 
     // produce terrain with transitions using a simple, relative naive approach (considers each tile once, and doesn't allow re-consideration if selection was bad)
     while (!transitionList.isEmpty()) {
+        // stop when a newer brush update was requested
+        if (job->canceled)
+            return;
+
         // get the next point in the consideration list
         QPoint p = transitionList.front();
         transitionList.pop_front();
@@ -375,10 +352,10 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
 
         // if we have already considered this point, skip to the next
         // TODO: we might want to allow re-consideration if prior tiles... but not for now, this would risk infinite loops
-        if (checked[i])
+        if (newTerrain.contains(i))
             continue;
 
-        const Tile *tile = currentLayer->cellAt(p).tile;
+        const Tile *tile = layer->cellAt(p).tile;
 
         // get the tileset for this tile
         Tileset *tileset = NULL;
@@ -395,16 +372,16 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
             // for the initial tiles, we will insert the selected terrain and add the surroundings for consideration
             unsigned int currentTerrain = tile->terrain();
 
-            if (mBrushMode == PaintTile) {
+            if (job->brushMode == TerrainBrush::PaintTile) {
                 // set the whole tile to the selected terrain
-                preferredTerrain = makeTerrain(mTerrain->id());
+                preferredTerrain = makeTerrain(job->terrain->id());
                 mask = 0xFFFFFFFF;
             } else {
                 // calculate the corner mask
-                mask = 0xFF << (3 - paintCorner)*8;
+                mask = 0xFF << (3 - job->paintCorner)*8;
 
                 // mask in the selected terrain
-                preferredTerrain = (currentTerrain & ~mask) | (mTerrain->id() << (3 - paintCorner)*8);
+                preferredTerrain = (currentTerrain & ~mask) | (job->terrain->id() << (3 - job->paintCorner)*8);
             }
 
             --initialTiles;
@@ -418,20 +395,21 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
             mask = 0;
 
             // depending which connections have been set, we update the preferred terrain of the tile accordingly
-            if (y > 0 && checked[i - layerWidth]) {
-                preferredTerrain = (newTerrain[i - layerWidth]->terrain() << 16) | (preferredTerrain & 0x0000FFFF);
+            QHash<int, Tile*>::const_iterator it;
+            if (y > 0 && (it = newTerrain.constFind(i - layerWidth)) != newTerrain.constEnd()) {
+                preferredTerrain = (it.value()->terrain() << 16) | (preferredTerrain & 0x0000FFFF);
                 mask |= 0xFFFF0000;
             }
-            if (y < layerHeight - 1 && checked[i + layerWidth]) {
-                preferredTerrain = (newTerrain[i + layerWidth]->terrain() >> 16) | (preferredTerrain & 0xFFFF0000);
+            if (y < layerHeight - 1 && (it = newTerrain.constFind(i + layerWidth)) != newTerrain.constEnd()) {
+                preferredTerrain = (it.value()->terrain() >> 16) | (preferredTerrain & 0xFFFF0000);
                 mask |= 0x0000FFFF;
             }
-            if (x > 0 && checked[i - 1]) {
-                preferredTerrain = ((newTerrain[i - 1]->terrain() << 8) & 0xFF00FF00) | (preferredTerrain & 0x00FF00FF);
+            if (x > 0 && (it = newTerrain.constFind(i - 1)) != newTerrain.constEnd()) {
+                preferredTerrain = ((it.value()->terrain() << 8) & 0xFF00FF00) | (preferredTerrain & 0x00FF00FF);
                 mask |= 0xFF00FF00;
             }
-            if (x < layerWidth - 1 && checked[i + 1]) {
-                preferredTerrain = ((newTerrain[i + 1]->terrain() >> 8) & 0x00FF00FF) | (preferredTerrain & 0xFF00FF00);
+            if (x < layerWidth - 1 && (it = newTerrain.constFind(i + 1)) != newTerrain.constEnd()) {
+                preferredTerrain = ((it.value()->terrain() >> 8) & 0x00FF00FF) | (preferredTerrain & 0xFF00FF00);
                 mask |= 0x00FF00FF;
             }
         }
@@ -444,59 +422,145 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
         }
 
         // add tile to the brush
-        newTerrain[i] = paste;
-        checked[i] = true;
+        newTerrain.insert(i, paste);
 
         // expand the brush rect to fit the edit set
         brushRect |= QRect(p, p);
 
         // consider surrounding tiles if terrain constraints were not satisfied
-        if (y > 0 && !checked[i - layerWidth]) {
-            const Tile *above = currentLayer->cellAt(x, y - 1).tile;
+        if (y > 0 && !newTerrain.contains(i - layerWidth)) {
+            const Tile *above = layer->cellAt(x, y - 1).tile;
             if (paste->topEdge() != above->bottomEdge())
                 transitionList.push_back(QPoint(x, y - 1));
         }
-        if (y < layerHeight - 1 && !checked[i + layerWidth]) {
-            const Tile *below = currentLayer->cellAt(x, y + 1).tile;
+        if (y < layerHeight - 1 && !newTerrain.contains(i + layerWidth)) {
+            const Tile *below = layer->cellAt(x, y + 1).tile;
             if (paste->bottomEdge() != below->topEdge())
                 transitionList.push_back(QPoint(x, y + 1));
         }
-        if (x > 0 && !checked[i - 1]) {
-            const Tile *left = currentLayer->cellAt(x - 1, y).tile;
+        if (x > 0 && !newTerrain.contains(i - 1)) {
+            const Tile *left = layer->cellAt(x - 1, y).tile;
             if (paste->leftEdge() != left->rightEdge())
                 transitionList.push_back(QPoint(x - 1, y));
         }
-        if (x < layerWidth - 1 && !checked[i + 1]) {
-            const Tile *right = currentLayer->cellAt(x + 1, y).tile;
+        if (x < layerWidth - 1 && !newTerrain.contains(i + 1)) {
+            const Tile *right = layer->cellAt(x + 1, y).tile;
             if (paste->rightEdge() != right->leftEdge())
                 transitionList.push_back(QPoint(x + 1, y));
         }
     }
 
     // create a stamp for the terrain block
-    TileLayer *stamp = new TileLayer(QString(), 0, 0, brushRect.width(), brushRect.height());
+    job->stamp = new TileLayer(QString(), 0, 0, brushRect.width(), brushRect.height());
+
+    QHash<int, Tile*>::const_iterator it = newTerrain.constBegin();
+    QHash<int, Tile*>::const_iterator it_end = newTerrain.constEnd();
+    for (; it != it_end; ++it) {
+        int x = it.key() % layerWidth;
+        int y = it.key() / layerWidth;
+
+        Tile *tile = it.value();
+        if (tile)
+            job->stamp->setCell(x - brushRect.left(), y - brushRect.top(), Cell(tile));
+        else {
+            // TODO: we need to do something to erase tiles that were considered, and have a NULL tile
+            // is there an eraser stamp? investigate how the eraser works...
+        }
+    }
 
-    for (int y = brushRect.top(); y <= brushRect.bottom(); ++y) {
-        for (int x = brushRect.left(); x <= brushRect.right(); ++x) {
-            int i = y*layerWidth + x;
-            if (!checked[i])
-                continue;
+    job->brushRect = brushRect;
+}
 
-            Tile *tile = newTerrain[i];
-            if (tile)
-                stamp->setCell(x - brushRect.left(), y - brushRect.top(), Cell(tile));
-            else {
-                // TODO: we need to do something to erase tiles where checked[i] is true, and newTerrain[i] is NULL
-                // is there an eraser stamp? investigate how the eraser works...
-            }
+void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
+{
+    // get the current tile layer
+    TileLayer *currentLayer = currentTileLayer();
+    Q_ASSERT(currentLayer);
+
+    int layerWidth = currentLayer->width();
+    int layerHeight = currentLayer->height();
+    int paintCorner = 0;
+
+    // if we are in vertex paint mode, the bottom right corner on the map will appear as an invalid tile offset...
+    if (mBrushMode == PaintVertex) {
+        if (cursorPos.x() == layerWidth) {
+            cursorPos.setX(cursorPos.x() - 1);
+            paintCorner |= 1;
+        }
+        if (cursorPos.y() == layerHeight) {
+            cursorPos.setY(cursorPos.y() - 1);
+            paintCorner |= 2;
         }
     }
 
-    // set the new tile layer as the brush
-    brushItem()->setTileLayer(stamp);
+    // if the cursor is outside of the map, bail out
+    if (!currentLayer->bounds().contains(cursorPos))
+        return;
+
+    cancelBrushUpdate();
+
+    // forget about the canceled computations that have finished
+    for (int i = mCanceledJobs.size() - 1; i >= 0; --i)
+        if (mCanceledJobs.at(i).isFinished())
+            mCanceledJobs.removeAt(i);
 
-    delete[] checked;
-    delete[] newTerrain;
+    // the clone shares its cells with the current layer until it is changed
+    mJob = QSharedPointer<TerrainBrushJob>(new TerrainBrushJob);
+    mJob->layer = static_cast<TileLayer*>(currentLayer->clone());
+    mJob->terrain = mTerrain;
+    mJob->brushMode = mBrushMode;
+    mJob->paintCorner = paintCorner;
+    mJob->cursorPos = cursorPos;
+    if (list)
+        mJob->startPoints = *list;
+    else
+        mJob->startPoints.append(cursorPos);
+
+    mJobWatcher.setFuture(QtConcurrent::run(computeTerrainBrush, mJob));
+
+    mPaintX = cursorPos.x();
+    mPaintY = cursorPos.y();
+}
+
+void TerrainBrush::finishBrushUpdate()
+{
+    if (!mJob)
+        return;
+
+    mJobWatcher.waitForFinished();
+    brushUpdateFinished();
+}
+
+void TerrainBrush::cancelBrushUpdate()
+{
+    if (!mJob)
+        return;
+
+    // the computation is left to finish by itself, its result is ignored
+    mJob->canceled = 1;
+    mJob.clear();
+
+    mCanceledJobs.append(mJobWatcher.future());
+}
+
+void TerrainBrush::waitForCanceledBrushUpdates()
+{
+    foreach (QFuture<void> future, mCanceledJobs)
+        future.waitForFinished();
+    mCanceledJobs.clear();
+}
+
+void TerrainBrush::brushUpdateFinished()
+{
+    // ignore computations that were canceled or were already applied
+    if (!mJob || !mJobWatcher.future().isFinished())
+        return;
+
+    QSharedPointer<TerrainBrushJob> job = mJob;
+    mJob.clear();
+
+    // set the new tile layer as the brush
+    brushItem()->setTileLayer(job->stamp);
 
 /*
     const QPoint tilePos = tilePosition();
@@ -506,10 +570,9 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
     }
 */
 
+    const QRect &brushRect = job->brushRect;
     brushItem()->setTileLayerPosition(QPoint(brushRect.left(), brushRect.top()));
 
-    mPaintX = cursorPos.x();
-    mPaintY = cursorPos.y();
-    mOffsetX = cursorPos.x() - brushRect.left();
-    mOffsetY = cursorPos.y() - brushRect.top();
+    mOffsetX = job->cursorPos.x() - brushRect.left();
+    mOffsetY = job->cursorPos.y() - brushRect.top();
 }
@@ -26,6 +26,9 @@
 #include "abstracttiletool.h"
 #include "tilelayer.h"
 
+#include <QFutureWatcher>
+#include <QSharedPointer>
+
 namespace Tiled {
 
 class Tile;
@@ -34,6 +37,7 @@ class Terrain;
 namespace Internal {
 
 class MapDocument;
+class TerrainBrushJob;
 
 /**
  * Implements a tile brush that paints terrain with automatic transitions.
@@ -89,6 +93,9 @@ protected:
     void mapDocumentChanged(MapDocument *oldDocument,
                             MapDocument *newDocument);
 
+private slots:
+    void brushUpdateFinished();
+
 private:
     void beginPaint();
 
@@ -102,17 +109,39 @@ private:
 
     void capture();
 
-    Tile *findBestTile(Tileset *tileset, unsigned int terrain, unsigned int considerationMask);
-
     /**
-     * updates the brush given new coordinates.
+     * updates the brush given new coordinates. The brush is computed in the
+     * background, and replaces the current brush when it is done.
      */
     void updateBrush(QPoint cursorPos, const QVector<QPoint> *list = NULL);
 
+    /**
+     * Waits for a pending brush update and applies its result.
+     */
+    void finishBrushUpdate();
+
+    /**
+     * Cancels a pending brush update, discarding its result.
+     */
+    void cancelBrushUpdate();
+
+    /**
+     * Waits for the canceled brush updates that are still running.
+     */
+    void waitForCanceledBrushUpdates();
+
     /**
      * The terrain we are currently painting.
      */
     const Terrain *mTerrain;
+
+    /**
+     * The pending brush update, and the watcher of its computation.
+     */
+    QSharedPointer<TerrainBrushJob> mJob;
+    QFutureWatcher<void> mJobWatcher;
+    QList<QFuture<void> > mCanceledJobs;
+
     int mPaintX, mPaintY;
     int mOffsetX, mOffsetY;
 
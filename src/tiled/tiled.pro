@@ -65,13 +65,16 @@ SOURCES += aboutdialog.cpp \
     commanddatamodel.cpp \
     commanddialog.cpp \
     commandlineparser.cpp \
+    compressedcells.cpp \
     createobjecttool.cpp \
     documentmanager.cpp \
     editpolygontool.cpp \
     eraser.cpp \
     erasetiles.cpp \
     filesystemwatcher.cpp \
+    fillpattern.cpp \
     filltiles.cpp \
+    floodfill.cpp \
     geometry.cpp \
     imagelayeritem.cpp \
     imagelayerpropertiesdialog.cpp \
@@ -131,6 +134,7 @@ SOURCES += aboutdialog.cpp \
     tmxmapreader.cpp \
     tmxmapwriter.cpp \
     toolmanager.cpp \
+    undobudget.cpp \
     undodock.cpp \
     utils.cpp \
     zoomable.cpp \
@@ -166,13 +170,16 @@ HEADERS += aboutdialog.h \
     commanddialog.h \
     command.h \
     commandlineparser.h \
+    compressedcells.h \
     createobjecttool.h \
     documentmanager.h \
     editpolygontool.h \
     eraser.h \
     erasetiles.h \
     filesystemwatcher.h \
+    fillpattern.h \
     filltiles.h \
+    floodfill.h \
     geometry.h \
     imagelayeritem.h \
     imagelayerpropertiesdialog.h \
@@ -235,6 +242,7 @@ HEADERS += aboutdialog.h \
     tmxmapreader.h \
     tmxmapwriter.h \
     toolmanager.h \
+    undobudget.h \
     undocommands.h \
     undodock.h \
     utils.h \
@@ -24,6 +24,7 @@
 #include "tilelayer.h"
 #include "map.h"
 #include "maprenderer.h"
+#include "mapscene.h"
 
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
@@ -56,6 +57,10 @@ void TileLayerItem::paint(QPainter *painter,
                           const QStyleOptionGraphicsItem *option,
                           QWidget *)
 {
+    QList<const TileLayer*> occluders;
+    if (MapScene *mapScene = qobject_cast<MapScene*>(scene()))
+        occluders = mapScene->occludingLayers(mLayer);
+
     // TODO: Display a border around the layer when selected
-    mRenderer->drawTileLayer(painter, mLayer, option->exposedRect);
+    mRenderer->drawTileLayer(painter, mLayer, option->exposedRect, occluders);
 }
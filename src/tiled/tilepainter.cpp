@@ -21,7 +21,9 @@
 
 #include "tilepainter.h"
 
+#include "floodfill.h"
 #include "mapdocument.h"
+#include "sparsecells.h"
 #include "tilelayer.h"
 #include "map.h"
 
@@ -47,8 +49,8 @@ Cell TilePainter::cellAt(int x, int y) const
 
 void TilePainter::setCell(int x, int y, const Cell &cell)
 {
-    const QRegion &selection = mMapDocument->tileSelection();
-    if (!(selection.isEmpty() || selection.contains(QPoint(x, y))))
+    const OccupancyBitmap &selection = mMapDocument->tileSelectionBitmap();
+    if (!(selection.isEmpty() || selection.contains(x, y)))
         return;
 
     const int layerX = x - mTileLayer->x();
@@ -58,7 +60,7 @@ void TilePainter::setCell(int x, int y, const Cell &cell)
         return;
 
     mTileLayer->setCell(layerX, layerY, cell);
-    mMapDocument->emitRegionChanged(QRegion(x, y, 1, 1));
+    mMapDocument->emitRegionChanged(QRegion(x, y, 1, 1), mTileLayer);
 }
 
 void TilePainter::setCells(int x, int y,
@@ -78,7 +80,7 @@ void TilePainter::setCells(int x, int y,
                          tileLayer,
                          region.translated(-mTileLayer->position()));
 
-    mMapDocument->emitRegionChanged(region);
+    mMapDocument->emitRegionChanged(region, mTileLayer);
 }
 
 void TilePainter::drawCells(int x, int y, TileLayer *tileLayer)
@@ -103,7 +105,17 @@ void TilePainter::drawCells(int x, int y, TileLayer *tileLayer)
         }
     }
 
-    mMapDocument->emitRegionChanged(region);
+    mMapDocument->emitRegionChanged(region, mTileLayer);
+}
+
+void TilePainter::setCells(const SparseCells &cells, const QRegion &region)
+{
+    const QRegion paintable = paintableRegion(region);
+    if (paintable.isEmpty())
+        return;
+
+    cells.apply(mTileLayer, paintable);
+    mMapDocument->emitRegionChanged(paintable, mTileLayer);
 }
 
 void TilePainter::drawStamp(const TileLayer *stamp,
@@ -137,7 +149,7 @@ void TilePainter::drawStamp(const TileLayer *stamp,
         }
     }
 
-    mMapDocument->emitRegionChanged(region);
+    mMapDocument->emitRegionChanged(region, mTileLayer);
 }
 
 void TilePainter::erase(const QRegion &region)
@@ -147,117 +159,19 @@ void TilePainter::erase(const QRegion &region)
         return;
 
     mTileLayer->erase(paintable.translated(-mTileLayer->position()));
-    mMapDocument->emitRegionChanged(paintable);
+    mMapDocument->emitRegionChanged(paintable, mTileLayer);
 }
 
 QRegion TilePainter::computeFillRegion(const QPoint &fillOrigin) const
 {
-    // Create that region that will hold the fill
-    QRegion fillRegion;
-
-    // Silently quit if parameters are unsatisfactory
-    if (!isDrawable(fillOrigin.x(), fillOrigin.y()))
-        return fillRegion;
-
-    // Cache cell that we will match other cells against
-    const Cell matchCell = cellAt(fillOrigin.x(), fillOrigin.y());
-
-    // Grab map dimensions for later use.
-    const int mapWidth = mMapDocument->map()->width();
-    const int mapHeight = mMapDocument->map()->height();
-    const int mapSize = mapWidth * mapHeight;
-
-    // Create a queue to hold cells that need filling
-    QList<QPoint> fillPositions;
-    fillPositions.append(fillOrigin);
-
-    // Create an array that will store which cells have been processed
-    // This is faster than checking if a given cell is in the region/list
-    QVector<quint8> processedCellsVec(mapSize);
-    quint8 *processedCells = processedCellsVec.data();
-
-    // Loop through queued positions and fill them, while at the same time
-    // checking adjacent positions to see if they should be added
-    while (!fillPositions.empty()) {
-        const QPoint currentPoint = fillPositions.takeFirst();
-        const int startOfLine = currentPoint.y() * mapWidth;
-
-        // Seek as far left as we can
-        int left = currentPoint.x();
-        while (cellAt(left - 1, currentPoint.y()) == matchCell &&
-               isDrawable(left - 1, currentPoint.y()))
-            --left;
-
-        // Seek as far right as we can
-        int right = currentPoint.x();
-        while (cellAt(right + 1, currentPoint.y()) == matchCell &&
-               isDrawable(right + 1, currentPoint.y()))
-            ++right;
-
-        // Add cells between left and right to the region
-        fillRegion += QRegion(left, currentPoint.y(), right - left + 1, 1);
-
-        // Add cell strip to processed cells
-        memset(&processedCells[startOfLine + left],
-               1,
-               right - left);
-
-        // These variables cache whether the last cell was added to the queue
-        // or not as an optimization, since adjacent cells on the x axis
-        // do not need to be added to the queue.
-        bool lastAboveCell = false;
-        bool lastBelowCell = false;
-
-        // Loop between left and right and check if cells above or
-        // below need to be added to the queue
-        for (int x = left; x <= right; ++x) {
-            const QPoint fillPoint(x, currentPoint.y());
-
-            // Check cell above
-            if (fillPoint.y() > 0) {
-                QPoint aboveCell(fillPoint.x(), fillPoint.y() - 1);
-                if (!processedCells[aboveCell.y()*mapWidth + aboveCell.x()] &&
-                    cellAt(aboveCell.x(), aboveCell.y()) == matchCell &&
-                    isDrawable(aboveCell.x(), aboveCell.y()))
-                {
-                    // Do not add the above cell to the queue if its
-                    // x-adjacent cell was added.
-                    if (!lastAboveCell)
-                        fillPositions.append(aboveCell);
-
-                    lastAboveCell = true;
-                } else lastAboveCell = false;
-
-                processedCells[aboveCell.y() * mapWidth + aboveCell.x()] = 1;
-            }
-
-            // Check cell below
-            if (fillPoint.y() + 1 < mapHeight) {
-                QPoint belowCell(fillPoint.x(), fillPoint.y() + 1);
-                if (!processedCells[belowCell.y()*mapWidth + belowCell.x()] &&
-                    cellAt(belowCell.x(), belowCell.y()) == matchCell &&
-                    isDrawable(belowCell.x(), belowCell.y()))
-                {
-                    // Do not add the below cell to the queue if its
-                    // x-adjacent cell was added.
-                    if (!lastBelowCell)
-                        fillPositions.append(belowCell);
-
-                    lastBelowCell = true;
-                } else lastBelowCell = false;
-
-                processedCells[belowCell.y() * mapWidth + belowCell.x()] = 1;
-            }
-        }
-    }
-
-    return fillRegion;
+    const FloodFill floodFill(mTileLayer, mMapDocument->tileSelection());
+    return floodFill.compute(fillOrigin);
 }
 
 bool TilePainter::isDrawable(int x, int y) const
 {
-    const QRegion &selection = mMapDocument->tileSelection();
-    if (!(selection.isEmpty() || selection.contains(QPoint(x, y))))
+    const OccupancyBitmap &selection = mMapDocument->tileSelectionBitmap();
+    if (!(selection.isEmpty() || selection.contains(x, y)))
         return false;
 
     const int layerX = x - mTileLayer->x();
@@ -274,9 +188,9 @@ QRegion TilePainter::paintableRegion(const QRegion &region) const
     const QRegion bounds = QRegion(mTileLayer->bounds());
     QRegion intersection = bounds.intersected(region);
 
-    const QRegion &selection = mMapDocument->tileSelection();
+    const OccupancyBitmap &selection = mMapDocument->tileSelectionBitmap();
     if (!selection.isEmpty())
-        intersection &= selection;
+        intersection = selection.toRegion(intersection);
 
     return intersection;
 }
@@ -27,6 +27,7 @@
 namespace Tiled {
 
 class Cell;
+class SparseCells;
 class TileLayer;
 
 namespace Internal {
@@ -83,6 +84,12 @@ public:
      */
     void drawCells(int x, int y, TileLayer *tileLayer);
 
+    /**
+     * Sets the given \a cells that fall within \a region. The positions of
+     * the cells and the region are relative to the map origin.
+     */
+    void setCells(const SparseCells &cells, const QRegion &region);
+
     /**
      * Draws the stamp within the given \a drawRegion region, repeating the
      * stamp as needed.
@@ -0,0 +1,147 @@
+/*
+ * undobudget.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "undobudget.h"
+
+#include "preferences.h"
+
+#include <QMap>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+CompressibleCommand::CompressibleCommand()
+    : mAccountedUsage(0)
+    , mLastUsed(0)
+{
+}
+
+CompressibleCommand::~CompressibleCommand()
+{
+    if (UndoBudget *budget = UndoBudget::instance())
+        budget->removeCommand(this);
+}
+
+void CompressibleCommand::memoryUsageChanged()
+{
+    if (UndoBudget *budget = UndoBudget::instance())
+        budget->updateCommand(this);
+}
+
+UndoBudget *UndoBudget::mInstance = 0;
+
+UndoBudget::UndoBudget(QObject *parent)
+    : QObject(parent)
+    , mUseCount(0)
+    , mLimit(0)
+    , mUsage(0)
+{
+    Q_ASSERT(!mInstance);
+    mInstance = this;
+
+    Preferences *prefs = Preferences::instance();
+    undoMemoryLimitChanged(prefs->undoMemoryLimit());
+
+    connect(prefs, SIGNAL(undoMemoryLimitChanged(int)),
+            SLOT(undoMemoryLimitChanged(int)));
+}
+
+UndoBudget::~UndoBudget()
+{
+    mInstance = 0;
+}
+
+void UndoBudget::setLimit(qint64 limit)
+{
+    if (mLimit == limit)
+        return;
+
+    mLimit = limit;
+    emit limitChanged(mLimit);
+    applyLimit();
+}
+
+void UndoBudget::undoMemoryLimitChanged(int megabytes)
+{
+    setLimit(qint64(megabytes) * 1024 * 1024);
+}
+
+void UndoBudget::updateCommand(CompressibleCommand *command)
+{
+    mCommands.insert(command);
+    command->mLastUsed = ++mUseCount;
+
+    const qint64 usage = command->memoryUsage();
+    const qint64 change = usage - command->mAccountedUsage;
+    command->mAccountedUsage = usage;
+
+    // The command reporting its usage is likely in the middle of being
+    // undone or redone, so it is left alone
+    if (change != 0) {
+        setUsage(mUsage + change);
+        applyLimit(command);
+    }
+}
+
+void UndoBudget::removeCommand(CompressibleCommand *command)
+{
+    if (mCommands.remove(command))
+        setUsage(mUsage - command->mAccountedUsage);
+}
+
+/**
+ * Compresses the commands that were least recently used, until the usage is
+ * within the limit. Only looks at the commands when the limit is exceeded.
+ */
+void UndoBudget::applyLimit(const CompressibleCommand *except)
+{
+    if (mLimit <= 0 || mUsage <= mLimit)
+        return;
+
+    // Each use has a unique number, so this orders them by their last use
+    QMap<quint64, CompressibleCommand*> commands;
+    foreach (CompressibleCommand *command, mCommands)
+        commands.insert(command->mLastUsed, command);
+
+    qint64 usage = mUsage;
+    foreach (CompressibleCommand *command, commands) {
+        if (usage <= mLimit)
+            break;
+        if (command == except)
+            continue;
+
+        command->compress();
+
+        const qint64 compressedUsage = command->memoryUsage();
+        usage += compressedUsage - command->mAccountedUsage;
+        command->mAccountedUsage = compressedUsage;
+    }
+
+    setUsage(usage);
+}
+
+void UndoBudget::setUsage(qint64 usage)
+{
+    if (mUsage == usage)
+        return;
+
+    mUsage = usage;
+    emit usageChanged(mUsage);
+}
@@ -0,0 +1,128 @@
+/*
+ * undobudget.h
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UNDOBUDGET_H
+#define UNDOBUDGET_H
+
+#include <QObject>
+#include <QSet>
+
+namespace Tiled {
+namespace Internal {
+
+/**
+ * Interface implemented by undo commands that hold on to a considerable
+ * amount of data, so that it can be accounted for by the UndoBudget.
+ */
+class CompressibleCommand
+{
+public:
+    CompressibleCommand();
+    virtual ~CompressibleCommand();
+
+    /**
+     * Returns the approximate number of bytes used by the data of this
+     * command.
+     */
+    virtual qint64 memoryUsage() const = 0;
+
+    /**
+     * Reduces the memory used by this command, for example by compressing
+     * its data. The data should be restored when the command is undone or
+     * redone. The default implementation does nothing.
+     */
+    virtual void compress() {}
+
+protected:
+    /**
+     * Lets the UndoBudget know that the memory used by this command may have
+     * changed. Should be called once the data of the command is complete,
+     * and whenever it changes after that, for example when the command is
+     * undone, redone or merged. The command also counts as recently used.
+     */
+    void memoryUsageChanged();
+
+private:
+    friend class UndoBudget;
+
+    qint64 mAccountedUsage;
+    quint64 mLastUsed;
+};
+
+/**
+ * Keeps track of the memory used by the undo commands. When the memory limit
+ * is exceeded, the commands that were least recently used are compressed
+ * until the usage is within the limit again.
+ *
+ * The commands report their own memory usage, so that a running total can be
+ * kept without going over all the undo stacks.
+ */
+class UndoBudget : public QObject
+{
+    Q_OBJECT
+
+public:
+    UndoBudget(QObject *parent = 0);
+    ~UndoBudget();
+
+    /**
+     * Returns the undo budget the commands report to, if any.
+     */
+    static UndoBudget *instance() { return mInstance; }
+
+    /**
+     * Returns the memory limit in bytes. A limit of 0 means there is no
+     * limit.
+     */
+    qint64 limit() const { return mLimit; }
+    void setLimit(qint64 limit);
+
+    /**
+     * Returns the number of bytes currently used by the undo commands.
+     */
+    qint64 usage() const { return mUsage; }
+
+signals:
+    void limitChanged(qint64 limit);
+    void usageChanged(qint64 usage);
+
+private slots:
+    void undoMemoryLimitChanged(int megabytes);
+
+private:
+    friend class CompressibleCommand;
+
+    void updateCommand(CompressibleCommand *command);
+    void removeCommand(CompressibleCommand *command);
+    void applyLimit(const CompressibleCommand *except = 0);
+    void setUsage(qint64 usage);
+
+    QSet<CompressibleCommand*> mCommands;
+    quint64 mUseCount;
+    qint64 mLimit;
+    qint64 mUsage;
+
+    static UndoBudget *mInstance;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // UNDOBUDGET_H
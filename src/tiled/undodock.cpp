@@ -21,15 +21,20 @@
 
 #include "undodock.h"
 
+#include "undobudget.h"
+
 #include <QEvent>
+#include <QLabel>
 #include <QUndoView>
 #include <QVBoxLayout>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
 
-UndoDock::UndoDock(QUndoGroup *undoGroup, QWidget *parent)
+UndoDock::UndoDock(QUndoGroup *undoGroup, UndoBudget *undoBudget,
+                   QWidget *parent)
     : QDockWidget(parent)
+    , mUndoBudget(undoBudget)
 {
     setObjectName(QLatin1String("undoViewDock"));
 
@@ -39,10 +44,18 @@ UndoDock::UndoDock(QUndoGroup *undoGroup, QWidget *parent)
     mUndoView->setUniformItemSizes(true);
     mUndoView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
 
+    mMemoryLabel = new QLabel(this);
+
     QWidget *widget = new QWidget(this);
     QVBoxLayout *layout = new QVBoxLayout(widget);
     layout->setMargin(5);
     layout->addWidget(mUndoView);
+    layout->addWidget(mMemoryLabel);
+
+    connect(mUndoBudget, SIGNAL(limitChanged(qint64)),
+            SLOT(updateMemoryLabel()));
+    connect(mUndoBudget, SIGNAL(usageChanged(qint64)),
+            SLOT(updateMemoryLabel()));
 
     setWidget(widget);
     retranslateUi();
@@ -64,4 +77,20 @@ void UndoDock::retranslateUi()
 {
     setWindowTitle(tr("History"));
     mUndoView->setEmptyLabel(tr("<empty>"));
+    updateMemoryLabel();
+}
+
+void UndoDock::updateMemoryLabel()
+{
+    const double megabyte = 1024 * 1024;
+    const QString usage = QString::number(mUndoBudget->usage() / megabyte,
+                                          'f', 1);
+
+    if (mUndoBudget->limit() > 0) {
+        const QString limit = QString::number(mUndoBudget->limit() / megabyte,
+                                              'f', 0);
+        mMemoryLabel->setText(tr("Memory: %1 of %2 MB").arg(usage, limit));
+    } else {
+        mMemoryLabel->setText(tr("Memory: %1 MB").arg(usage));
+    }
 }
@@ -24,12 +24,15 @@
 
 #include <QDockWidget>
 
+class QLabel;
 class QUndoGroup;
 class QUndoView;
 
 namespace Tiled {
 namespace Internal {
 
+class UndoBudget;
+
 /**
  * A dock widget showing the undo stack. Mainly for debugging, but can also be
  * useful for the user.
@@ -39,14 +42,20 @@ class UndoDock : public QDockWidget
     Q_OBJECT
 
 public:
-    UndoDock(QUndoGroup *undoGroup, QWidget *parent = 0);
+    UndoDock(QUndoGroup *undoGroup, UndoBudget *undoBudget,
+             QWidget *parent = 0);
 
 protected:
     void changeEvent(QEvent *e);
 
+private slots:
+    void updateMemoryLabel();
+
 private:
     void retranslateUi();
     QUndoView *mUndoView;
+    UndoBudget *mUndoBudget;
+    QLabel *mMemoryLabel;
 };
 
 } // namespace Internal
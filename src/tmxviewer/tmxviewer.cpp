@@ -44,36 +44,6 @@
 
 using namespace Tiled;
 
-/**
- * Item that represents a map object.
- */
-class MapObjectItem : public QGraphicsItem
-{
-public:
-    MapObjectItem(MapObject *mapObject, MapRenderer *renderer,
-                  QGraphicsItem *parent = 0)
-        : QGraphicsItem(parent)
-        , mMapObject(mapObject)
-        , mRenderer(renderer)
-    {}
-
-    QRectF boundingRect() const
-    {
-        return mRenderer->boundingRect(mMapObject);
-    }
-
-    void paint(QPainter *p, const QStyleOptionGraphicsItem *, QWidget *)
-    {
-        const QColor &color = mMapObject->objectGroup()->color();
-        mRenderer->drawMapObject(p, mMapObject,
-                                 color.isValid() ? color : Qt::darkGray);
-    }
-
-private:
-    MapObject *mMapObject;
-    MapRenderer *mRenderer;
-};
-
 /**
  * Item that represents a tile layer.
  */
@@ -81,10 +51,12 @@ class TileLayerItem : public QGraphicsItem
 {
 public:
     TileLayerItem(TileLayer *tileLayer, MapRenderer *renderer,
+                  const QList<const TileLayer*> &occluders,
                   QGraphicsItem *parent = 0)
         : QGraphicsItem(parent)
         , mTileLayer(tileLayer)
         , mRenderer(renderer)
+        , mOccluders(occluders)
     {
         setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
     }
@@ -96,16 +68,19 @@ public:
 
     void paint(QPainter *p, const QStyleOptionGraphicsItem *option, QWidget *)
     {
-        mRenderer->drawTileLayer(p, mTileLayer, option->rect);
+        mRenderer->drawTileLayer(p, mTileLayer, option->rect, mOccluders);
     }
 
 private:
     TileLayer *mTileLayer;
     MapRenderer *mRenderer;
+    QList<const TileLayer*> mOccluders;
 };
 
 /**
- * Item that represents an object group.
+ * Item that represents an object group. Only the objects that intersect the
+ * exposed area are drawn, which are looked up using the spatial index of the
+ * object group.
  */
 class ObjectGroupItem : public QGraphicsItem
 {
@@ -113,16 +88,39 @@ public:
     ObjectGroupItem(ObjectGroup *objectGroup, MapRenderer *renderer,
                     QGraphicsItem *parent = 0)
         : QGraphicsItem(parent)
+        , mObjectGroup(objectGroup)
+        , mRenderer(renderer)
     {
-        setFlag(QGraphicsItem::ItemHasNoContents);
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
 
-        // Create a child item for each object
-        foreach (MapObject *object, objectGroup->objects())
-            new MapObjectItem(object, renderer, this);
+        foreach (const MapObject *object, objectGroup->objects())
+            mBoundingRect |= renderer->boundingRect(object);
     }
 
-    QRectF boundingRect() const { return QRectF(); }
-    void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) {}
+    QRectF boundingRect() const { return mBoundingRect; }
+
+    void paint(QPainter *p, const QStyleOptionGraphicsItem *option, QWidget *)
+    {
+        const QColor &groupColor = mObjectGroup->color();
+        const QColor color = groupColor.isValid() ? groupColor : Qt::darkGray;
+
+        // Objects may be drawn slightly outside of their bounds
+        const qreal margin = MapRenderer::objectMargin();
+        const QRectF exposed = option->exposedRect.adjusted(-margin, -margin,
+                                                            margin, margin);
+        const QRectF tileRect = mRenderer->pixelToTileBoundingRect(exposed);
+
+        foreach (const MapObject *object,
+                 mObjectGroup->objectsIntersecting(tileRect)) {
+            if (object->isVisible())
+                mRenderer->drawMapObject(p, object, color);
+        }
+    }
+
+private:
+    ObjectGroup *mObjectGroup;
+    MapRenderer *mRenderer;
+    QRectF mBoundingRect;
 };
 
 /**
@@ -136,10 +134,17 @@ public:
     {
         setFlag(QGraphicsItem::ItemHasNoContents);
 
+        // The tile layers drawn on top of the current one, topmost first
+        QList<const TileLayer*> occluders;
+        foreach (Layer *layer, map->layers())
+            if (TileLayer *tileLayer = layer->asTileLayer())
+                occluders.prepend(tileLayer);
+
         // Create a child item for each layer
         foreach (Layer *layer, map->layers()) {
             if (TileLayer *tileLayer = layer->asTileLayer()) {
-                new TileLayerItem(tileLayer, renderer, this);
+                occluders.removeLast();
+                new TileLayerItem(tileLayer, renderer, occluders, this);
             } else if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
                 new ObjectGroupItem(objectGroup, renderer, this);
             }
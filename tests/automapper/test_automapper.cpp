@@ -0,0 +1,541 @@
+#include "automapper.h"
+#include "automapperwrapper.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QScopedPointer>
+#include <QUndoStack>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+class test_AutoMapper : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void parallelMatchesSerial_data();
+    void parallelMatchesSerial();
+
+    void sequentialMatchesFindMatches_data();
+    void sequentialMatchesFindMatches();
+
+    void undoRestoresMap();
+
+    void matchesBaseline_data();
+    void matchesBaseline();
+
+private:
+    Map *createWorkingMap() const;
+    Map *createRulesMap(bool noOverlappingRules,
+                        bool outputFeedsInput = false) const;
+    MapDocument *autoMapped(bool noOverlappingRules, int threadCount,
+                            const QRect &where = QRect(),
+                            bool outputFeedsInput = false) const;
+
+    void setRows(TileLayer *layer, int x, int y, const char * const *rows,
+                 int rowCount) const;
+
+    Tileset *mTileset;
+};
+
+void test_AutoMapper::initTestCase()
+{
+    QImage image(16 * 6, 16, QImage::Format_ARGB32);
+    QPainter painter(&image);
+    for (int i = 0; i < 6; ++i)
+        painter.fillRect(i * 16, 0, 16, 16, QColor::fromHsv(i * 60, 255, 255));
+    painter.end();
+
+    mTileset = new Tileset(QLatin1String("tiles"), 16, 16);
+    QVERIFY(mTileset->loadFromImage(image, QString()));
+    TilesetManager::instance()->addReference(mTileset);
+}
+
+void test_AutoMapper::cleanupTestCase()
+{
+    TilesetManager::instance()->removeReference(mTileset);
+    mTileset = 0;
+}
+
+/**
+ * Creates a map with a "set" layer filled with a fixed pseudo-random
+ * pattern of the first three tiles.
+ */
+Map *test_AutoMapper::createWorkingMap() const
+{
+    Map *map = new Map(Map::Orthogonal, 160, 120, 16, 16);
+    map->addTileset(mTileset);
+
+    TileLayer *set = new TileLayer(QLatin1String("set"), 0, 0, 160, 120);
+    quint32 random = 12345;
+    for (int y = 0; y < set->height(); ++y) {
+        for (int x = 0; x < set->width(); ++x) {
+            random = random * 1103515245 + 12345;
+            set->setCell(x, y, Cell(mTileset->tileAt((random >> 16) % 3)));
+        }
+    }
+    map->addLayer(set);
+
+    return map;
+}
+
+/**
+ * Creates a rules map with three rules, each having two alternative outputs
+ * to the "out" layer.
+ *
+ * When \a outputFeedsInput is set, both outputs also write the input tiles
+ * of each rule back to the "set" layer. This leaves the "set" layer
+ * unchanged, but makes the AutoMapper apply the rules one after the other
+ * since their output could affect their input.
+ */
+Map *test_AutoMapper::createRulesMap(bool noOverlappingRules,
+                                     bool outputFeedsInput) const
+{
+    Map *map = new Map(Map::Orthogonal, 12, 2, 16, 16);
+    map->addTileset(mTileset);
+    if (noOverlappingRules)
+        map->setProperty(QLatin1String("NoOverlappingRules"),
+                         QLatin1String("true"));
+
+    TileLayer *regions = new TileLayer(QLatin1String("regions"), 0, 0, 12, 2);
+    TileLayer *input = new TileLayer(QLatin1String("input_set"), 0, 0, 12, 2);
+    TileLayer *inputNot = new TileLayer(QLatin1String("inputnot_set"),
+                                        0, 0, 12, 2);
+    TileLayer *output1 = new TileLayer(QLatin1String("output1_out"),
+                                       0, 0, 12, 2);
+    TileLayer *output2 = new TileLayer(QLatin1String("output2_out"),
+                                       0, 0, 12, 2);
+
+    const Cell region(mTileset->tileAt(0));
+    for (int y = 0; y < 2; ++y) {
+        regions->setCell(0, y, region);
+        regions->setCell(1, y, region);
+        regions->setCell(4, y, region);
+    }
+    regions->setCell(8, 0, region);
+    regions->setCell(9, 0, region);
+
+    // Rule 1: tile 0 next to tile 1, anything below
+    input->setCell(0, 0, Cell(mTileset->tileAt(0)));
+    input->setCell(1, 0, Cell(mTileset->tileAt(1)));
+    output1->setCell(0, 1, Cell(mTileset->tileAt(3)));
+    output2->setCell(1, 1, Cell(mTileset->tileAt(4)));
+
+    // Rule 2: tile 2 not above tile 2
+    input->setCell(4, 0, Cell(mTileset->tileAt(2)));
+    inputNot->setCell(4, 1, Cell(mTileset->tileAt(2)));
+    output1->setCell(4, 0, Cell(mTileset->tileAt(5)));
+    output2->setCell(4, 1, Cell(mTileset->tileAt(5)));
+
+    // Rule 3: tile 1 followed by anything
+    input->setCell(8, 0, Cell(mTileset->tileAt(1)));
+    output1->setCell(9, 0, Cell(mTileset->tileAt(4)));
+    output2->setCell(8, 0, Cell(mTileset->tileAt(3)));
+
+    map->addLayer(regions);
+    map->addLayer(input);
+    map->addLayer(inputNot);
+    map->addLayer(output1);
+    map->addLayer(output2);
+
+    if (outputFeedsInput) {
+        TileLayer *output1Set = new TileLayer(QLatin1String("output1_set"),
+                                              0, 0, 12, 2);
+        TileLayer *output2Set = new TileLayer(QLatin1String("output2_set"),
+                                              0, 0, 12, 2);
+        for (int y = 0; y < 2; ++y) {
+            for (int x = 0; x < 12; ++x) {
+                output1Set->setCell(x, y, input->cellAt(x, y));
+                output2Set->setCell(x, y, input->cellAt(x, y));
+            }
+        }
+        map->addLayer(output1Set);
+        map->addLayer(output2Set);
+    }
+
+    return map;
+}
+
+/**
+ * Automaps the given region of the working map, or the whole map when
+ * \a where is null.
+ */
+MapDocument *test_AutoMapper::autoMapped(bool noOverlappingRules,
+                                         int threadCount,
+                                         const QRect &where,
+                                         bool outputFeedsInput) const
+{
+    Map *map = createWorkingMap();
+    MapDocument *mapDocument = new MapDocument(map, QString());
+
+    Map *rules = createRulesMap(noOverlappingRules, outputFeedsInput);
+    TilesetManager::instance()->addReferences(rules->tilesets());
+
+    AutoMapper autoMapper(mapDocument, rules, QLatin1String("rules.tmx"));
+    autoMapper.setThreadCount(threadCount);
+    autoMapper.setRandomSeed(42);
+    if (!autoMapper.errorString().isEmpty() || !autoMapper.prepareAutoMap()) {
+        qWarning() << autoMapper.errorString();
+        delete mapDocument;
+        return 0;
+    }
+
+    QRegion region(where.isNull() ? QRect(0, 0, map->width(), map->height())
+                                  : where);
+    autoMapper.autoMap(&region);
+    autoMapper.cleanAll();
+
+    return mapDocument;
+}
+
+static bool sameCells(const TileLayer *a, const TileLayer *b)
+{
+    if (a->bounds() != b->bounds())
+        return false;
+
+    for (int y = 0; y < a->height(); ++y)
+        for (int x = 0; x < a->width(); ++x)
+            if (a->cellAt(x, y) != b->cellAt(x, y))
+                return false;
+
+    return true;
+}
+
+void test_AutoMapper::parallelMatchesSerial_data()
+{
+    QTest::addColumn<bool>("noOverlappingRules");
+    QTest::addColumn<int>("threadCount");
+
+    QTest::newRow("2 threads") << false << 2;
+    QTest::newRow("8 threads") << false << 8;
+    QTest::newRow("2 threads, no overlap") << true << 2;
+    QTest::newRow("8 threads, no overlap") << true << 8;
+}
+
+void test_AutoMapper::parallelMatchesSerial()
+{
+    QFETCH(bool, noOverlappingRules);
+    QFETCH(int, threadCount);
+
+    MapDocument *serial = autoMapped(noOverlappingRules, 1);
+    MapDocument *parallel = autoMapped(noOverlappingRules, threadCount);
+    QVERIFY(serial);
+    QVERIFY(parallel);
+
+    const Map *serialMap = serial->map();
+    const Map *parallelMap = parallel->map();
+    QCOMPARE(parallelMap->layerCount(), serialMap->layerCount());
+
+    const int outIndex = serialMap->indexOfLayer(QLatin1String("out"));
+    QVERIFY(outIndex != -1);
+    QVERIFY(!serialMap->layerAt(outIndex)->isEmpty());
+
+    for (int i = 0; i < serialMap->layerCount(); ++i) {
+        TileLayer *serialLayer = serialMap->layerAt(i)->asTileLayer();
+        TileLayer *parallelLayer = parallelMap->layerAt(i)->asTileLayer();
+        QVERIFY(serialLayer && parallelLayer);
+        QCOMPARE(parallelLayer->name(), serialLayer->name());
+        QVERIFY(sameCells(serialLayer, parallelLayer));
+    }
+
+    delete serial;
+    delete parallel;
+}
+
+void test_AutoMapper::sequentialMatchesFindMatches_data()
+{
+    QTest::addColumn<QRect>("where");
+
+    QTest::newRow("whole map") << QRect();
+    QTest::newRow("sub-region") << QRect(40, 30, 20, 15);
+    QTest::newRow("map edge") << QRect(150, 0, 10, 7);
+}
+
+/**
+ * Checks that applying the rules one after the other, as done when the
+ * output of the rules may affect their input, gives the same result as
+ * collecting all matches up front.
+ */
+void test_AutoMapper::sequentialMatchesFindMatches()
+{
+    QFETCH(QRect, where);
+
+    QScopedPointer<MapDocument> found(autoMapped(false, 1, where, false));
+    QScopedPointer<MapDocument> sequential(autoMapped(false, 1, where, true));
+    QVERIFY(found);
+    QVERIFY(sequential);
+
+    const Map *foundMap = found->map();
+    const Map *sequentialMap = sequential->map();
+    QCOMPARE(sequentialMap->layerCount(), foundMap->layerCount());
+
+    const int outIndex = foundMap->indexOfLayer(QLatin1String("out"));
+    QVERIFY(outIndex != -1);
+    QVERIFY(!foundMap->layerAt(outIndex)->isEmpty());
+
+    for (int i = 0; i < foundMap->layerCount(); ++i) {
+        TileLayer *foundLayer = foundMap->layerAt(i)->asTileLayer();
+        TileLayer *sequentialLayer = sequentialMap->layerAt(i)->asTileLayer();
+        QVERIFY(foundLayer && sequentialLayer);
+        QCOMPARE(sequentialLayer->name(), foundLayer->name());
+        QVERIFY(sameCells(foundLayer, sequentialLayer));
+    }
+}
+
+/**
+ * Automaps part of the map the way the editor does, and checks that undoing
+ * it restores the original map. Rules may change the map well outside of the
+ * region being automapped, and all of those changes need to be undone.
+ */
+void test_AutoMapper::undoRestoresMap()
+{
+    QScopedPointer<MapDocument> mapDocument(
+                new MapDocument(createWorkingMap(), QString()));
+
+    Map *rules = createRulesMap(false);
+    TilesetManager::instance()->addReferences(rules->tilesets());
+
+    QScopedPointer<AutoMapper> autoMapper(
+                new AutoMapper(mapDocument.data(), rules,
+                               QLatin1String("rules.tmx")));
+    QVERIFY(autoMapper->errorString().isEmpty());
+
+    QVector<AutoMapper*> autoMappers;
+    autoMappers.append(autoMapper.data());
+
+    QRegion where(40, 30, 20, 15);
+    QUndoStack *undoStack = mapDocument->undoStack();
+    undoStack->push(new AutoMapperWrapper(mapDocument.data(), autoMappers,
+                                          &where));
+
+    const Map *map = mapDocument->map();
+    const int outIndex = map->indexOfLayer(QLatin1String("out"));
+    QVERIFY(outIndex != -1);
+    QVERIFY(!map->layerAt(outIndex)->isEmpty());
+
+    undoStack->undo();
+
+    QScopedPointer<Map> original(createWorkingMap());
+    for (int i = 0; i < map->layerCount(); ++i) {
+        TileLayer *layer = map->layerAt(i)->asTileLayer();
+        QVERIFY(layer);
+
+        const int index = original->indexOfLayer(layer->name());
+        if (index == -1) {
+            // Layers added by the automapping are left empty
+            QVERIFY(layer->isEmpty());
+            continue;
+        }
+
+        TileLayer *originalLayer = original->layerAt(index)->asTileLayer();
+        QVERIFY(sameCells(originalLayer, layer));
+    }
+}
+
+/*
+ * A small working map with the result of automapping it with the rules
+ * below, as worked out by hand following the original AutoMapper: each rule
+ * is applied in turn, at every position in scan order, and with
+ * NoOverlappingRules a match is skipped when its output would overlap an
+ * earlier output of the same rule. Digits are tile ids, dots are empty.
+ */
+static const char * const baselineSet[] = {
+    "0111201120",
+    "1210112211",
+    "2011100120",
+};
+
+static const char * const baselineOut[] = {
+    ".221552155",
+    ".4..214421",
+    "55221..355",
+};
+
+static const char * const baselineOutNoOverlap[] = {
+    ".21.552155",
+    ".4..214421",
+    "5521...355",
+};
+
+/*
+ * The rules, each with a single output so that the result does not depend
+ * on the random seed: tile 0 followed by 1 puts a 3 on the 1, 1 above 2 puts
+ * a 4 on the 2, 2 followed by 0 puts 5 on both and 1 followed by 1 puts a 2
+ * and a 1 on them, which may overlap with its own earlier output.
+ */
+static const char * const baselineRegions[] = {
+    "00.0.00.00",
+    "...0......",
+};
+
+static const char * const baselineInput[] = {
+    "01.1.20.11",
+    "...2......",
+};
+
+static const char * const baselineOutput[] = {
+    ".3...55.21",
+    "...4......",
+};
+
+static const int baselineWidth = 10;
+static const int baselineHeight = 3;
+
+/*
+ * The fixture is repeated with empty tiles in between, which no rule can
+ * match, to make the map large enough to be matched on multiple threads.
+ */
+static const int baselineRepeatX = 8;
+static const int baselineRepeatY = 20;
+
+/**
+ * Sets the cells of \a layer from the given \a rows of tile ids, starting
+ * at \a x, \a y. Dots are left empty.
+ */
+void test_AutoMapper::setRows(TileLayer *layer, int x, int y,
+                              const char * const *rows, int rowCount) const
+{
+    for (int j = 0; j < rowCount; ++j) {
+        for (int i = 0; rows[j][i]; ++i) {
+            if (rows[j][i] != '.')
+                layer->setCell(x + i, y + j,
+                               Cell(mTileset->tileAt(rows[j][i] - '0')));
+        }
+    }
+}
+
+/**
+ * Returns the tile ids of the cells in \a layer as rows, see setRows().
+ */
+static QStringList rowsOf(const TileLayer *layer)
+{
+    QStringList rows;
+    for (int y = 0; y < layer->height(); ++y) {
+        QString row;
+        for (int x = 0; x < layer->width(); ++x) {
+            const Cell &cell = layer->cellAt(x, y);
+            row += cell.isEmpty() ? QLatin1Char('.')
+                                  : QLatin1Char(char('0' + cell.tile->id()));
+        }
+        rows.append(row);
+    }
+    return rows;
+}
+
+/**
+ * Returns the given \a rows of the fixture, repeated like the working map.
+ */
+static QStringList repeatedRows(const char * const *rows)
+{
+    QStringList result;
+    for (int j = 0; j < baselineRepeatY; ++j) {
+        for (int y = 0; y < baselineHeight; ++y) {
+            QString row = QLatin1String(rows[y]);
+            row += QLatin1Char('.');
+            result.append(row.repeated(baselineRepeatX));
+        }
+        result.append(QString(baselineRepeatX * (baselineWidth + 1),
+                              QLatin1Char('.')));
+    }
+    return result;
+}
+
+void test_AutoMapper::matchesBaseline_data()
+{
+    QTest::addColumn<bool>("noOverlappingRules");
+    QTest::addColumn<int>("threadCount");
+    QTest::addColumn<bool>("outputFeedsInput");
+
+    QTest::newRow("serial") << false << 1 << false;
+    QTest::newRow("serial, no overlap") << true << 1 << false;
+    QTest::newRow("4 threads") << false << 4 << false;
+    QTest::newRow("4 threads, no overlap") << true << 4 << false;
+    QTest::newRow("sequential") << false << 1 << true;
+    QTest::newRow("sequential, no overlap") << true << 1 << true;
+}
+
+/**
+ * Checks the result of automapping against the fixture above, both when
+ * looking for all matches up front, on one or more threads, and when
+ * applying the rules one after the other.
+ */
+void test_AutoMapper::matchesBaseline()
+{
+    QFETCH(bool, noOverlappingRules);
+    QFETCH(int, threadCount);
+    QFETCH(bool, outputFeedsInput);
+
+    const int width = baselineRepeatX * (baselineWidth + 1);
+    const int height = baselineRepeatY * (baselineHeight + 1);
+
+    Map *map = new Map(Map::Orthogonal, width, height, 16, 16);
+    map->addTileset(mTileset);
+    TileLayer *set = new TileLayer(QLatin1String("set"), 0, 0, width, height);
+    for (int j = 0; j < baselineRepeatY; ++j)
+        for (int i = 0; i < baselineRepeatX; ++i)
+            setRows(set, i * (baselineWidth + 1), j * (baselineHeight + 1),
+                    baselineSet, baselineHeight);
+    map->addLayer(set);
+    QScopedPointer<MapDocument> mapDocument(new MapDocument(map, QString()));
+
+    Map *rules = new Map(Map::Orthogonal, baselineWidth, 2, 16, 16);
+    rules->addTileset(mTileset);
+    if (noOverlappingRules)
+        rules->setProperty(QLatin1String("NoOverlappingRules"),
+                           QLatin1String("true"));
+
+    TileLayer *regions = new TileLayer(QLatin1String("regions"),
+                                       0, 0, baselineWidth, 2);
+    TileLayer *input = new TileLayer(QLatin1String("input_set"),
+                                     0, 0, baselineWidth, 2);
+    TileLayer *output = new TileLayer(QLatin1String("output_out"),
+                                      0, 0, baselineWidth, 2);
+    setRows(regions, 0, 0, baselineRegions, 2);
+    setRows(input, 0, 0, baselineInput, 2);
+    setRows(output, 0, 0, baselineOutput, 2);
+    rules->addLayer(regions);
+    rules->addLayer(input);
+    rules->addLayer(output);
+
+    // Writing the input tiles back to the "set" layer leaves it unchanged,
+    // but makes the AutoMapper apply the rules one after the other.
+    if (outputFeedsInput) {
+        TileLayer *outputSet = new TileLayer(QLatin1String("output_set"),
+                                             0, 0, baselineWidth, 2);
+        setRows(outputSet, 0, 0, baselineInput, 2);
+        rules->addLayer(outputSet);
+    }
+
+    TilesetManager::instance()->addReferences(rules->tilesets());
+
+    AutoMapper autoMapper(mapDocument.data(), rules,
+                          QLatin1String("rules.tmx"));
+    autoMapper.setThreadCount(threadCount);
+    QVERIFY(autoMapper.errorString().isEmpty());
+    QVERIFY(autoMapper.prepareAutoMap());
+
+    QRegion region(0, 0, width, height);
+    autoMapper.autoMap(&region);
+    autoMapper.cleanAll();
+
+    const int outIndex = map->indexOfLayer(QLatin1String("out"));
+    QVERIFY(outIndex != -1);
+
+    QCOMPARE(rowsOf(set), repeatedRows(baselineSet));
+    QCOMPARE(rowsOf(map->layerAt(outIndex)->asTileLayer()),
+             repeatedRows(noOverlappingRules ? baselineOutNoOverlap
+                                             : baselineOut));
+}
+
+QTEST_MAIN(test_AutoMapper)
+#include "test_automapper.moc"
@@ -0,0 +1,292 @@
+#include "automapper.h"
+#include "automapperwrapper.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QScopedPointer>
+#include <QUndoStack>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+/**
+ * Benchmarks the AutoMapper on generated maps and rules.
+ *
+ * The map sizes, rule counts and rule sizes can be set with the comma
+ * separated TILED_BENCHMARK_MAP_SIZES, TILED_BENCHMARK_RULE_COUNTS and
+ * TILED_BENCHMARK_RULE_SIZES environment variables. By default only a
+ * 256x256 map is used, so that the benchmark runs quickly along with the
+ * other tests. Larger maps, like 1024 or 4096, need to be asked for
+ * explicitly. Run with -xml to get the results in a machine-readable
+ * format.
+ */
+class test_AutoMapperBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void prepareAutoMap_data();
+    void prepareAutoMap();
+
+    void autoMap_data();
+    void autoMap();
+
+    void autoMapperWrapper_data();
+    void autoMapperWrapper();
+
+private:
+    void addRows();
+
+    MapDocument *createMapDocument(int mapSize) const;
+    Map *createRulesMap(int ruleCount, int ruleSize) const;
+
+    Tileset *mTileset;
+};
+
+/**
+ * The first two tiles are used on the map and by the rule inputs, the
+ * others by the rule outputs.
+ */
+static const int inputTileCount = 2;
+static const int tileCount = 6;
+
+static QList<int> valuesFromEnvironment(const char *name,
+                                        const QList<int> &defaults)
+{
+    const QByteArray value = qgetenv(name);
+    if (value.isEmpty())
+        return defaults;
+
+    QList<int> values;
+    foreach (const QByteArray &part, value.split(',')) {
+        bool ok;
+        const int number = part.trimmed().toInt(&ok);
+        if (ok && number > 0)
+            values.append(number);
+    }
+    return values;
+}
+
+/**
+ * A simple linear congruential generator, so that the generated maps and
+ * rules are the same on every run and platform.
+ */
+static int nextRandom(quint32 &state, int range)
+{
+    state = state * 1103515245 + 12345;
+    return (state >> 16) % range;
+}
+
+void test_AutoMapperBenchmark::initTestCase()
+{
+    QImage image(16 * tileCount, 16, QImage::Format_ARGB32);
+    QPainter painter(&image);
+    for (int i = 0; i < tileCount; ++i)
+        painter.fillRect(i * 16, 0, 16, 16,
+                         QColor::fromHsv(i * 360 / tileCount, 255, 255));
+    painter.end();
+
+    mTileset = new Tileset(QLatin1String("tiles"), 16, 16);
+    QVERIFY(mTileset->loadFromImage(image, QString()));
+    TilesetManager::instance()->addReference(mTileset);
+}
+
+void test_AutoMapperBenchmark::cleanupTestCase()
+{
+    TilesetManager::instance()->removeReference(mTileset);
+    mTileset = 0;
+}
+
+void test_AutoMapperBenchmark::addRows()
+{
+    QTest::addColumn<int>("mapSize");
+    QTest::addColumn<int>("ruleCount");
+    QTest::addColumn<int>("ruleSize");
+
+    const QList<int> mapSizes =
+            valuesFromEnvironment("TILED_BENCHMARK_MAP_SIZES",
+                                  QList<int>() << 256);
+    const QList<int> ruleCounts =
+            valuesFromEnvironment("TILED_BENCHMARK_RULE_COUNTS",
+                                  QList<int>() << 16);
+    const QList<int> ruleSizes =
+            valuesFromEnvironment("TILED_BENCHMARK_RULE_SIZES",
+                                  QList<int>() << 2 << 3);
+
+    foreach (int mapSize, mapSizes) {
+        foreach (int ruleCount, ruleCounts) {
+            foreach (int ruleSize, ruleSizes) {
+                const QString name =
+                        QString(QLatin1String("%1x%1, %2 rules of %3x%3"))
+                        .arg(mapSize).arg(ruleCount).arg(ruleSize);
+                QTest::newRow(name.toLatin1().constData())
+                        << mapSize << ruleCount << ruleSize;
+            }
+        }
+    }
+}
+
+/**
+ * Creates a map document with a "set" layer of the given size, filled with
+ * a fixed pseudo-random pattern of the input tiles.
+ */
+MapDocument *test_AutoMapperBenchmark::createMapDocument(int mapSize) const
+{
+    Map *map = new Map(Map::Orthogonal, mapSize, mapSize, 16, 16);
+    map->addTileset(mTileset);
+
+    TileLayer *set = new TileLayer(QLatin1String("set"), 0, 0,
+                                   mapSize, mapSize);
+    quint32 random = 12345;
+    for (int y = 0; y < mapSize; ++y)
+        for (int x = 0; x < mapSize; ++x)
+            set->setCell(x, y, Cell(mTileset->tileAt(
+                                        nextRandom(random, inputTileCount))));
+    map->addLayer(set);
+
+    return new MapDocument(map, QString());
+}
+
+/**
+ * Creates a rules map with \a ruleCount rules next to each other. Each rule
+ * requires a fixed pseudo-random square of \a ruleSize input tiles, and
+ * writes a single tile to the "out" layer.
+ */
+Map *test_AutoMapperBenchmark::createRulesMap(int ruleCount,
+                                              int ruleSize) const
+{
+    const int width = ruleCount * (ruleSize + 1);
+    const int height = ruleSize;
+
+    Map *map = new Map(Map::Orthogonal, width, height, 16, 16);
+    map->addTileset(mTileset);
+
+    TileLayer *regions = new TileLayer(QLatin1String("regions"), 0, 0,
+                                       width, height);
+    TileLayer *input = new TileLayer(QLatin1String("input_set"), 0, 0,
+                                     width, height);
+    TileLayer *output = new TileLayer(QLatin1String("output_out"), 0, 0,
+                                      width, height);
+
+    quint32 random = 54321;
+    for (int i = 0; i < ruleCount; ++i) {
+        const int left = i * (ruleSize + 1);
+
+        for (int y = 0; y < ruleSize; ++y) {
+            for (int x = left; x < left + ruleSize; ++x) {
+                regions->setCell(x, y, Cell(mTileset->tileAt(0)));
+                input->setCell(x, y, Cell(mTileset->tileAt(
+                                              nextRandom(random,
+                                                         inputTileCount))));
+            }
+        }
+
+        const int outputTile = inputTileCount
+                + i % (tileCount - inputTileCount);
+        output->setCell(left, 0, Cell(mTileset->tileAt(outputTile)));
+    }
+
+    map->addLayer(regions);
+    map->addLayer(input);
+    map->addLayer(output);
+
+    TilesetManager::instance()->addReferences(map->tilesets());
+    return map;
+}
+
+void test_AutoMapperBenchmark::prepareAutoMap_data()
+{
+    addRows();
+}
+
+void test_AutoMapperBenchmark::prepareAutoMap()
+{
+    QFETCH(int, mapSize);
+    QFETCH(int, ruleCount);
+    QFETCH(int, ruleSize);
+
+    QScopedPointer<MapDocument> mapDocument(createMapDocument(mapSize));
+    AutoMapper autoMapper(mapDocument.data(),
+                          createRulesMap(ruleCount, ruleSize),
+                          QLatin1String("rules.tmx"));
+    QVERIFY(autoMapper.errorString().isEmpty());
+
+    bool prepared = false;
+    QBENCHMARK {
+        prepared = autoMapper.prepareAutoMap();
+    }
+    QVERIFY(prepared);
+
+    autoMapper.cleanAll();
+}
+
+void test_AutoMapperBenchmark::autoMap_data()
+{
+    addRows();
+}
+
+void test_AutoMapperBenchmark::autoMap()
+{
+    QFETCH(int, mapSize);
+    QFETCH(int, ruleCount);
+    QFETCH(int, ruleSize);
+
+    QScopedPointer<MapDocument> mapDocument(createMapDocument(mapSize));
+    AutoMapper autoMapper(mapDocument.data(),
+                          createRulesMap(ruleCount, ruleSize),
+                          QLatin1String("rules.tmx"));
+    QVERIFY(autoMapper.errorString().isEmpty());
+    QVERIFY(autoMapper.prepareAutoMap());
+
+    // Each run starts from the same map, so only run once
+    QRegion where(0, 0, mapSize, mapSize);
+    QBENCHMARK_ONCE {
+        autoMapper.autoMap(&where);
+    }
+
+    autoMapper.cleanAll();
+}
+
+void test_AutoMapperBenchmark::autoMapperWrapper_data()
+{
+    addRows();
+}
+
+/**
+ * Measures automapping the way the editor does it, which includes preparing
+ * the AutoMapper and remembering the changes for undo.
+ */
+void test_AutoMapperBenchmark::autoMapperWrapper()
+{
+    QFETCH(int, mapSize);
+    QFETCH(int, ruleCount);
+    QFETCH(int, ruleSize);
+
+    QScopedPointer<MapDocument> mapDocument(createMapDocument(mapSize));
+    QScopedPointer<AutoMapper> autoMapper(
+                new AutoMapper(mapDocument.data(),
+                               createRulesMap(ruleCount, ruleSize),
+                               QLatin1String("rules.tmx")));
+    QVERIFY(autoMapper->errorString().isEmpty());
+
+    QRegion where(0, 0, mapSize, mapSize);
+    QBENCHMARK_ONCE {
+        QVector<AutoMapper*> autoMappers;
+        autoMappers.append(autoMapper.data());
+        mapDocument->undoStack()->push(
+                    new AutoMapperWrapper(mapDocument.data(), autoMappers,
+                                          &where));
+    }
+}
+
+QTEST_MAIN(test_AutoMapperBenchmark)
+#include "test_automapperbenchmark.moc"
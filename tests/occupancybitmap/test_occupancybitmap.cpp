@@ -0,0 +1,215 @@
+#include "occupancybitmap.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+/**
+ * Compares an OccupancyBitmap with a QRegion holding the same positions. The
+ * positions are spread over several chunks, on both sides of the origin.
+ */
+class test_OccupancyBitmap : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void isEmpty();
+    void clear();
+
+    void chunkBorders_data();
+    void chunkBorders();
+
+    void randomRects();
+    void addBitmap();
+    void toRegionClipped();
+};
+
+/**
+ * A simple linear congruential generator, so that the tested positions are
+ * the same on every run and platform.
+ */
+static int nextRandom(quint32 &state, int range)
+{
+    state = state * 1103515245 + 12345;
+    return (state >> 16) % range;
+}
+
+/**
+ * Returns a rect within -160..159 on both axes, which spans chunks with
+ * negative as well as positive coordinates.
+ */
+static QRect randomRect(quint32 &random)
+{
+    return QRect(nextRandom(random, 320) - 160,
+                 nextRandom(random, 320) - 160,
+                 1 + nextRandom(random, 80),
+                 1 + nextRandom(random, 80));
+}
+
+/**
+ * Checks every position around the bounding rect of \a region.
+ */
+static bool sameContents(const OccupancyBitmap &bitmap, const QRegion &region)
+{
+    if (bitmap.isEmpty() != region.isEmpty())
+        return false;
+    if (bitmap.boundingRect() != region.boundingRect())
+        return false;
+    if (!(bitmap.toRegion() ^ region).isEmpty())
+        return false;
+
+    const QRect area = region.boundingRect().adjusted(-2, -2, 2, 2);
+    for (int y = area.top(); y <= area.bottom(); ++y)
+        for (int x = area.left(); x <= area.right(); ++x)
+            if (bitmap.contains(x, y) != region.contains(QPoint(x, y)))
+                return false;
+
+    return true;
+}
+
+void test_OccupancyBitmap::isEmpty()
+{
+    OccupancyBitmap bitmap;
+    QVERIFY(bitmap.isEmpty());
+    QVERIFY(bitmap.boundingRect().isNull());
+    QVERIFY(bitmap.toRegion().isEmpty());
+    QVERIFY(!bitmap.contains(0, 0));
+    QVERIFY(!bitmap.intersects(QRect(-100, -100, 200, 200)));
+
+    bitmap.add(QRect());
+    QVERIFY(bitmap.isEmpty());
+}
+
+void test_OccupancyBitmap::clear()
+{
+    OccupancyBitmap bitmap;
+    bitmap.add(QRect(-70, -70, 140, 140));
+    QVERIFY(!bitmap.isEmpty());
+    QVERIFY(bitmap.contains(-70, -70));
+
+    bitmap.clear();
+    QVERIFY(bitmap.isEmpty());
+    QVERIFY(!bitmap.contains(-70, -70));
+    QVERIFY(!bitmap.intersects(QRect(-70, -70, 140, 140)));
+    QVERIFY(bitmap.toRegion().isEmpty());
+}
+
+void test_OccupancyBitmap::chunkBorders_data()
+{
+    QTest::addColumn<QRect>("rect");
+
+    QTest::newRow("origin") << QRect(0, 0, 1, 1);
+    QTest::newRow("left of origin") << QRect(-1, -1, 1, 1);
+    QTest::newRow("last of chunk") << QRect(63, 63, 1, 1);
+    QTest::newRow("first of next chunk") << QRect(64, 64, 1, 1);
+    QTest::newRow("first of negative chunk") << QRect(-64, -64, 1, 1);
+    QTest::newRow("last of second negative chunk") << QRect(-65, -65, 1, 1);
+    QTest::newRow("across origin") << QRect(-2, -3, 4, 6);
+    QTest::newRow("across chunk border") << QRect(60, -70, 10, 12);
+    QTest::newRow("full chunk") << QRect(-64, 0, 64, 64);
+    QTest::newRow("several chunks") << QRect(-65, -129, 195, 260);
+    QTest::newRow("full rows") << QRect(-128, 5, 256, 2);
+}
+
+void test_OccupancyBitmap::chunkBorders()
+{
+    QFETCH(QRect, rect);
+
+    OccupancyBitmap bitmap;
+    bitmap.add(rect);
+    QVERIFY(sameContents(bitmap, QRegion(rect)));
+
+    // Each neighbouring position is outside, including across chunk borders
+    QVERIFY(!bitmap.intersects(QRect(rect.left() - 1, rect.top(),
+                                     1, rect.height())));
+    QVERIFY(!bitmap.intersects(QRect(rect.right() + 1, rect.top(),
+                                     1, rect.height())));
+    QVERIFY(!bitmap.intersects(QRect(rect.left(), rect.top() - 1,
+                                     rect.width(), 1)));
+    QVERIFY(!bitmap.intersects(QRect(rect.left(), rect.bottom() + 1,
+                                     rect.width(), 1)));
+    QVERIFY(bitmap.intersects(QRect(rect.right(), rect.bottom(), 5, 5)));
+    QVERIFY(bitmap.intersects(QRect(rect.left() - 4, rect.top() - 4, 5, 5)));
+}
+
+void test_OccupancyBitmap::randomRects()
+{
+    quint32 random = 1;
+
+    for (int i = 0; i < 50; ++i) {
+        OccupancyBitmap bitmap;
+        QRegion region;
+
+        for (int j = nextRandom(random, 8); j >= 0; --j) {
+            const QRect rect = randomRect(random);
+            bitmap.add(rect);
+            region += rect;
+        }
+        QVERIFY(sameContents(bitmap, region));
+
+        for (int j = 0; j < 50; ++j) {
+            const QRect rect = randomRect(random);
+            QCOMPARE(bitmap.intersects(rect), region.intersects(rect));
+        }
+
+        QRegion query;
+        for (int j = nextRandom(random, 4); j >= 0; --j)
+            query += randomRect(random);
+        QCOMPARE(bitmap.intersects(query), region.intersects(query));
+    }
+}
+
+void test_OccupancyBitmap::addBitmap()
+{
+    quint32 random = 2;
+
+    for (int i = 0; i < 20; ++i) {
+        OccupancyBitmap a;
+        OccupancyBitmap b;
+        QRegion region;
+
+        for (int j = 0; j < 4; ++j) {
+            const QRect rectA = randomRect(random);
+            const QRect rectB = randomRect(random);
+            a.add(rectA);
+            b.add(QRegion(rectB));
+            region += rectA;
+            region += rectB;
+        }
+
+        a.add(b);
+        QVERIFY(sameContents(a, region));
+    }
+}
+
+void test_OccupancyBitmap::toRegionClipped()
+{
+    quint32 random = 3;
+
+    for (int i = 0; i < 50; ++i) {
+        OccupancyBitmap bitmap;
+        QRegion region;
+
+        for (int j = nextRandom(random, 8); j >= 0; --j) {
+            const QRect rect = randomRect(random);
+            bitmap.add(rect);
+            region += rect;
+        }
+
+        // Clip rects that are next to each other produce runs that touch
+        QRegion clip;
+        for (int j = nextRandom(random, 6); j >= 0; --j) {
+            const QRect rect = randomRect(random);
+            clip += rect;
+            clip += QRect(rect.right() + 1, rect.top() + 1,
+                          1 + nextRandom(random, 40), rect.height());
+        }
+
+        const QRegion clipped = bitmap.toRegion(clip);
+        QVERIFY((clipped ^ (region & clip)).isEmpty());
+        QVERIFY(bitmap.toRegion(QRegion()).isEmpty());
+    }
+}
+
+QTEST_MAIN(test_OccupancyBitmap)
+#include "test_occupancybitmap.moc"
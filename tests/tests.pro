@@ -1,4 +1,8 @@
 TEMPLATE=subdirs
 SUBDIRS = \
+    automapper \
+    automapperbenchmark \
     mapreader \
-    staggeredrenderer
+    occupancybitmap \
+    staggeredrenderer \
+    tilelayer
@@ -0,0 +1,464 @@
+#include "sparsecells.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QScopedPointer>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+/**
+ * Compares the tile layer operations that work on the cells in place with
+ * straightforward per-cell implementations of the same operations.
+ */
+class test_TileLayer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void offset();
+    void offsetRoundTrip();
+    void resize();
+    void flip();
+    void rotate();
+    void computeDiffRegion();
+
+private:
+    TileLayer *randomLayer(quint32 &random, int width, int height) const;
+
+    Tileset *mTileset;
+};
+
+/**
+ * A simple linear congruential generator, so that the tested layers are the
+ * same on every run and platform.
+ */
+static int nextRandom(quint32 &state, int range)
+{
+    state = state * 1103515245 + 12345;
+    return (state >> 16) % range;
+}
+
+static bool sameCells(const TileLayer *a, const TileLayer *b)
+{
+    if (a->width() != b->width() || a->height() != b->height())
+        return false;
+
+    for (int y = 0; y < a->height(); ++y)
+        for (int x = 0; x < a->width(); ++x)
+            if (a->cellAt(x, y) != b->cellAt(x, y))
+                return false;
+
+    return true;
+}
+
+static TileLayer *cloneLayer(const TileLayer *layer)
+{
+    return static_cast<TileLayer*>(layer->clone());
+}
+
+/**
+ * Offsets the cells of \a layer one at a time, the way it was done before
+ * the cells were moved in place.
+ */
+static void referenceOffset(TileLayer *layer, const QPoint &offset,
+                            const QRect &bounds, bool wrapX, bool wrapY)
+{
+    QScopedPointer<TileLayer> original(cloneLayer(layer));
+
+    for (int y = 0; y < layer->height(); ++y) {
+        for (int x = 0; x < layer->width(); ++x) {
+            if (!bounds.contains(x, y))
+                continue;
+
+            int oldX = x - offset.x();
+            int oldY = y - offset.y();
+
+            if (wrapX && bounds.width() > 0) {
+                while (oldX < bounds.left())
+                    oldX += bounds.width();
+                while (oldX > bounds.right())
+                    oldX -= bounds.width();
+            }
+            if (wrapY && bounds.height() > 0) {
+                while (oldY < bounds.top())
+                    oldY += bounds.height();
+                while (oldY > bounds.bottom())
+                    oldY -= bounds.height();
+            }
+
+            if (original->contains(oldX, oldY) && bounds.contains(oldX, oldY))
+                layer->setCell(x, y, original->cellAt(oldX, oldY));
+            else
+                layer->setCell(x, y, Cell());
+        }
+    }
+}
+
+/**
+ * Returns the layer resized one cell at a time, the way it was done before
+ * the rows were copied at once.
+ */
+static TileLayer *referenceResize(const TileLayer *layer, const QSize &size,
+                                  const QPoint &offset)
+{
+    TileLayer *resized = new TileLayer(layer->name(), layer->x(), layer->y(),
+                                       size.width(), size.height());
+
+    for (int y = 0; y < layer->height(); ++y) {
+        for (int x = 0; x < layer->width(); ++x) {
+            const QPoint pos(x + offset.x(), y + offset.y());
+            if (resized->contains(pos))
+                resized->setCell(pos.x(), pos.y(), layer->cellAt(x, y));
+        }
+    }
+
+    return resized;
+}
+
+static TileLayer *referenceFlip(const TileLayer *layer,
+                                TileLayer::FlipDirection direction)
+{
+    const int width = layer->width();
+    const int height = layer->height();
+    TileLayer *flipped = new TileLayer(layer->name(), layer->x(), layer->y(),
+                                       width, height);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            Cell cell;
+            if (direction == TileLayer::FlipHorizontally) {
+                cell = layer->cellAt(width - x - 1, y);
+                cell.flippedHorizontally = !cell.flippedHorizontally;
+            } else {
+                cell = layer->cellAt(x, height - y - 1);
+                cell.flippedVertically = !cell.flippedVertically;
+            }
+            flipped->setCell(x, y, cell);
+        }
+    }
+
+    return flipped;
+}
+
+static TileLayer *referenceRotate(const TileLayer *layer,
+                                  TileLayer::RotateDirection direction)
+{
+    static const char rotateRightMask[8] = { 5, 4, 1, 0, 7, 6, 3, 2 };
+    static const char rotateLeftMask[8]  = { 3, 2, 7, 6, 1, 0, 5, 4 };
+
+    const char (&rotateMask)[8] =
+            (direction == TileLayer::RotateRight) ? rotateRightMask
+                                                  : rotateLeftMask;
+
+    const int width = layer->width();
+    const int height = layer->height();
+    TileLayer *rotated = new TileLayer(layer->name(), layer->x(), layer->y(),
+                                       height, width);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            Cell cell = layer->cellAt(x, y);
+
+            unsigned char mask =
+                    (cell.flippedHorizontally << 2) |
+                    (cell.flippedVertically << 1) |
+                    (cell.flippedAntiDiagonally << 0);
+
+            mask = rotateMask[mask];
+
+            cell.flippedHorizontally = (mask & 4) != 0;
+            cell.flippedVertically = (mask & 2) != 0;
+            cell.flippedAntiDiagonally = (mask & 1) != 0;
+
+            if (direction == TileLayer::RotateRight)
+                rotated->setCell(height - y - 1, x, cell);
+            else
+                rotated->setCell(y, width - x - 1, cell);
+        }
+    }
+
+    return rotated;
+}
+
+static QRegion referenceDiffRegion(const TileLayer *layer,
+                                   const TileLayer *other)
+{
+    QRegion ret;
+
+    const int dx = other->x() - layer->x();
+    const int dy = other->y() - layer->y();
+    QRect r = QRect(0, 0, layer->width(), layer->height());
+    r &= QRect(dx, dy, other->width(), other->height());
+
+    for (int y = r.top(); y <= r.bottom(); ++y)
+        for (int x = r.left(); x <= r.right(); ++x)
+            if (layer->cellAt(x, y) != other->cellAt(x - dx, y - dy))
+                ret += QRect(x, y, 1, 1);
+
+    return ret;
+}
+
+static int wrapped(int value, int size)
+{
+    value %= size;
+    return value < 0 ? value + size : value;
+}
+
+/**
+ * Returns the cells within \a bounds that are lost when offsetting
+ * \a layer, because they are moved out of the bounds or out of the layer.
+ */
+static QRegion referenceLostRegion(const TileLayer *layer,
+                                   const QPoint &offset, const QRect &bounds,
+                                   bool wrapX, bool wrapY)
+{
+    const QRect area = bounds & QRect(0, 0, layer->width(), layer->height());
+    QRegion lost;
+
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+        for (int x = area.left(); x <= area.right(); ++x) {
+            int newX = x + offset.x();
+            int newY = y + offset.y();
+            if (wrapX)
+                newX = bounds.left() + wrapped(newX - bounds.left(),
+                                               bounds.width());
+            if (wrapY)
+                newY = bounds.top() + wrapped(newY - bounds.top(),
+                                              bounds.height());
+
+            if (!area.contains(newX, newY))
+                lost += QRect(x, y, 1, 1);
+        }
+    }
+
+    return lost;
+}
+
+void test_TileLayer::initTestCase()
+{
+    QImage image(16 * 3, 16, QImage::Format_ARGB32);
+    QPainter painter(&image);
+    for (int i = 0; i < 3; ++i)
+        painter.fillRect(i * 16, 0, 16, 16, QColor::fromHsv(i * 120, 255, 255));
+    painter.end();
+
+    mTileset = new Tileset(QLatin1String("tiles"), 16, 16);
+    QVERIFY(mTileset->loadFromImage(image, QString()));
+}
+
+void test_TileLayer::cleanupTestCase()
+{
+    delete mTileset;
+    mTileset = 0;
+}
+
+/**
+ * Creates a layer filled with a pseudo-random pattern of empty cells and
+ * flipped tiles.
+ */
+TileLayer *test_TileLayer::randomLayer(quint32 &random,
+                                       int width, int height) const
+{
+    TileLayer *layer = new TileLayer(QLatin1String("layer"),
+                                     nextRandom(random, 5) - 2,
+                                     nextRandom(random, 5) - 2,
+                                     width, height);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const int tile = nextRandom(random, mTileset->tileCount() + 1);
+            if (tile == mTileset->tileCount())
+                continue;
+
+            Cell cell(mTileset->tileAt(tile));
+            cell.flippedHorizontally = nextRandom(random, 2) == 1;
+            cell.flippedVertically = nextRandom(random, 2) == 1;
+            cell.flippedAntiDiagonally = nextRandom(random, 2) == 1;
+            layer->setCell(x, y, cell);
+        }
+    }
+
+    return layer;
+}
+
+void test_TileLayer::offset()
+{
+    quint32 random = 1;
+
+    for (int i = 0; i < 2000; ++i) {
+        const int width = 1 + nextRandom(random, 9);
+        const int height = 1 + nextRandom(random, 9);
+        QScopedPointer<TileLayer> layer(randomLayer(random, width, height));
+        QScopedPointer<TileLayer> expected(cloneLayer(layer.data()));
+
+        const QRect bounds(nextRandom(random, 12) - 3,
+                           nextRandom(random, 12) - 3,
+                           1 + nextRandom(random, 12),
+                           1 + nextRandom(random, 12));
+        const QPoint offset(nextRandom(random, 31) - 15,
+                            nextRandom(random, 31) - 15);
+        const bool wrapX = nextRandom(random, 2) == 1;
+        const bool wrapY = nextRandom(random, 2) == 1;
+
+        layer->offset(offset, bounds, wrapX, wrapY);
+        referenceOffset(expected.data(), offset, bounds, wrapX, wrapY);
+        QVERIFY(sameCells(layer.data(), expected.data()));
+    }
+}
+
+/**
+ * Undoing an offset of a tile layer relies on the offset in the opposite
+ * direction restoring all cells, except for the ones that were lost.
+ */
+void test_TileLayer::offsetRoundTrip()
+{
+    quint32 random = 2;
+
+    for (int i = 0; i < 2000; ++i) {
+        const int width = 1 + nextRandom(random, 9);
+        const int height = 1 + nextRandom(random, 9);
+        QScopedPointer<TileLayer> original(randomLayer(random, width, height));
+        QScopedPointer<TileLayer> layer(cloneLayer(original.data()));
+
+        const QRect bounds(nextRandom(random, 12) - 3,
+                           nextRandom(random, 12) - 3,
+                           1 + nextRandom(random, 12),
+                           1 + nextRandom(random, 12));
+        const QPoint offset(nextRandom(random, 31) - 15,
+                            nextRandom(random, 31) - 15);
+        const bool wrapX = nextRandom(random, 2) == 1;
+        const bool wrapY = nextRandom(random, 2) == 1;
+
+        // Remember the lost cells the way OffsetLayer does, in map
+        // coordinates
+        const QRegion lostRegion =
+                referenceLostRegion(layer.data(), offset, bounds,
+                                    wrapX, wrapY)
+                .translated(layer->position());
+        SparseCells lostCells;
+        lostCells.copyCells(layer->x(), layer->y(), layer.data(),
+                            lostRegion, true);
+
+        layer->offset(offset, bounds, wrapX, wrapY);
+        layer->offset(-offset, bounds, wrapX, wrapY);
+
+        // Only the lost cells may differ, and they are left empty
+        const QRegion changed =
+                layer->computeDiffRegion(original.data())
+                .translated(layer->position());
+        QVERIFY((changed - lostRegion).isEmpty());
+        foreach (const QRect &rect, lostRegion.rects())
+            for (int y = rect.top(); y <= rect.bottom(); ++y)
+                for (int x = rect.left(); x <= rect.right(); ++x)
+                    QVERIFY(layer->cellAt(x - layer->x(),
+                                          y - layer->y()).isEmpty());
+
+        lostCells.apply(layer.data(), lostRegion);
+        QVERIFY(sameCells(layer.data(), original.data()));
+    }
+}
+
+void test_TileLayer::resize()
+{
+    quint32 random = 3;
+
+    for (int i = 0; i < 2000; ++i) {
+        const int width = 1 + nextRandom(random, 9);
+        const int height = 1 + nextRandom(random, 9);
+        QScopedPointer<TileLayer> layer(randomLayer(random, width, height));
+
+        const QSize size(1 + nextRandom(random, 12),
+                         1 + nextRandom(random, 12));
+        const QPoint offset(nextRandom(random, 25) - 12,
+                            nextRandom(random, 25) - 12);
+
+        QScopedPointer<TileLayer> expected(
+                    referenceResize(layer.data(), size, offset));
+        layer->resize(size, offset);
+        QVERIFY(sameCells(layer.data(), expected.data()));
+    }
+}
+
+void test_TileLayer::flip()
+{
+    quint32 random = 4;
+
+    // Sizes up to 70 cover layers of several rotation blocks
+    for (int i = 0; i < 200; ++i) {
+        const int width = 1 + nextRandom(random, 70);
+        const int height = 1 + nextRandom(random, 70);
+        QScopedPointer<TileLayer> layer(randomLayer(random, width, height));
+
+        for (int d = TileLayer::FlipHorizontally;
+             d <= TileLayer::FlipVertically; ++d) {
+            const TileLayer::FlipDirection direction =
+                    static_cast<TileLayer::FlipDirection>(d);
+
+            QScopedPointer<TileLayer> flipped(cloneLayer(layer.data()));
+            QScopedPointer<TileLayer> expected(
+                        referenceFlip(layer.data(), direction));
+            flipped->flip(direction);
+            QVERIFY(sameCells(flipped.data(), expected.data()));
+        }
+    }
+}
+
+void test_TileLayer::rotate()
+{
+    quint32 random = 5;
+
+    for (int i = 0; i < 200; ++i) {
+        const int width = 1 + nextRandom(random, 70);
+        const int height = 1 + nextRandom(random, 70);
+        QScopedPointer<TileLayer> layer(randomLayer(random, width, height));
+
+        for (int d = TileLayer::RotateLeft;
+             d <= TileLayer::RotateRight; ++d) {
+            const TileLayer::RotateDirection direction =
+                    static_cast<TileLayer::RotateDirection>(d);
+
+            QScopedPointer<TileLayer> rotated(cloneLayer(layer.data()));
+            QScopedPointer<TileLayer> expected(
+                        referenceRotate(layer.data(), direction));
+            rotated->rotate(direction);
+            QVERIFY(sameCells(rotated.data(), expected.data()));
+        }
+    }
+}
+
+void test_TileLayer::computeDiffRegion()
+{
+    quint32 random = 6;
+
+    for (int i = 0; i < 500; ++i) {
+        QScopedPointer<TileLayer> layer(
+                    randomLayer(random, 1 + nextRandom(random, 40),
+                                1 + nextRandom(random, 40)));
+        QScopedPointer<TileLayer> other(cloneLayer(layer.data()));
+
+        // Change some of the cells, or compare against an unrelated layer
+        if (nextRandom(random, 4) == 0) {
+            other.reset(randomLayer(random, 1 + nextRandom(random, 40),
+                                    1 + nextRandom(random, 40)));
+        } else {
+            for (int j = nextRandom(random, 20); j > 0; --j)
+                other->setCell(nextRandom(random, other->width()),
+                               nextRandom(random, other->height()),
+                               Cell());
+        }
+
+        const QRegion region = layer->computeDiffRegion(other.data());
+        const QRegion expected = referenceDiffRegion(layer.data(),
+                                                     other.data());
+        QVERIFY((region ^ expected).isEmpty());
+    }
+}
+
+QTEST_MAIN(test_TileLayer)
+#include "test_tilelayer.moc"